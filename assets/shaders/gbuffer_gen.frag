@@ -3,6 +3,7 @@
 in vec3 vsPos;
 in vec3 vsNormal;
 in vec2 uvCoord;
+flat in vec4 uvRegion;
 
 uniform sampler2D uDiffuseTexture;
 uniform vec3 uMaterial = vec3(1.0 /*ambient*/, 1.0 /*diffuse*/, 1.0 /*specular*/);
@@ -17,6 +18,14 @@ void main()
 {
 	outFragLinearDepth = vec4(-vsPos.z / uFarPlaneDist, 0.0, 0.0, 1.0);
 	outFragNormal = vec4(normalize(vsNormal), 0.0);
-	outFragDiffuse = texture(uDiffuseTexture, uvCoord);
+	if (uvRegion.z > 0.0) {
+		// Tile coordinates of a (possibly merged) chunk mesh quad, repeat texture inside atlas region.
+		// Gradients are taken from the continuous coordinates to avoid mip seams at tile borders.
+		vec2 atlasCoord = uvRegion.xy + fract(uvCoord) * uvRegion.zw;
+		outFragDiffuse = textureGrad(uDiffuseTexture, atlasCoord,
+		                             dFdx(uvCoord) * uvRegion.zw, dFdy(uvCoord) * uvRegion.zw);
+	} else {
+		outFragDiffuse = texture(uDiffuseTexture, uvCoord);
+	}
 	outFragMaterial = vec4(uMaterial, 1.0);
 }
\ No newline at end of file
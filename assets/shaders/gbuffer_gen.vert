@@ -3,23 +3,50 @@
 in vec3 inPosition;
 in vec3 inNormal;
 in vec2 inUVCoord;
+in uint inPackedVertex; // Chunk mesh vertex, see ChunkMesh for layout
 
 uniform mat4 uModelMatrix;
 uniform mat4 uViewMatrix;
 uniform mat4 uProjMatrix;
 
+uniform bool uPackedVertices = false;
+uniform vec4 uVoxelUVRegions[16]; // Texture atlas region (min.xy, dimensions.zw) per voxel type
+
 out vec3 vsPos;
 out vec3 vsNormal;
 out vec2 uvCoord;
+flat out vec4 uvRegion;
+
+// Per face (-x, +x, -y, +y, -z, +z): normal, the position axes u and v run along and their signs
+const vec3 FACE_NORMALS[6] = vec3[6](vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, -1, 0),
+                                     vec3(0, 1, 0), vec3(0, 0, -1), vec3(0, 0, 1));
+const ivec2 FACE_UV_AXES[6] = ivec2[6](ivec2(2, 1), ivec2(2, 1), ivec2(0, 2),
+                                       ivec2(0, 2), ivec2(0, 1), ivec2(0, 1));
+const vec2 FACE_UV_SIGNS[6] = vec2[6](vec2(1, 1), vec2(-1, 1), vec2(1, 1),
+                                      vec2(1, -1), vec2(-1, 1), vec2(1, 1));
 
 void main()
 {
+	vec3 position = inPosition;
+	vec3 normal = inNormal;
+	uvCoord = inUVCoord;
+	uvRegion = vec4(0.0);
+
+	if (uPackedVertices) {
+		position = vec3(inPackedVertex & 31u, (inPackedVertex >> 5) & 31u, (inPackedVertex >> 10) & 31u);
+		int face = int((inPackedVertex >> 15) & 7u);
+		int material = int((inPackedVertex >> 18) & 255u);
+		normal = FACE_NORMALS[face];
+		// UV coordinates count texture tiles, repeated inside the atlas region in the fragment shader
+		uvCoord = FACE_UV_SIGNS[face] * vec2(position[FACE_UV_AXES[face].x], position[FACE_UV_AXES[face].y]);
+		uvRegion = uVoxelUVRegions[material];
+	}
+
 	mat4 modelView = uViewMatrix * uModelMatrix;
 	mat4 modelViewProj = uProjMatrix * modelView;
 	mat4 normalMatrix = inverse(transpose(modelView)); // Needed for non-uniform scaling.
 
-	gl_Position = modelViewProj * vec4(inPosition, 1);	
-	vsPos = vec3(modelView * vec4(inPosition, 1));
-	vsNormal = normalize((normalMatrix * vec4(inNormal, 0)).xyz);
-	uvCoord = inUVCoord;
+	gl_Position = modelViewProj * vec4(position, 1);	
+	vsPos = vec3(modelView * vec4(position, 1));
+	vsNormal = normalize((normalMatrix * vec4(normal, 0)).xyz);
 }
\ No newline at end of file
@@ -1,12 +1,20 @@
 #version 330
 
 in vec3 inPosition;
+in uint inPackedVertex; // Chunk mesh vertex, see ChunkMesh for layout
 
 uniform mat4 uModelMatrix;
 uniform mat4 uViewProjMatrix;
 
+uniform bool uPackedVertices = false;
+
 void main()
 {
+	vec3 position = inPosition;
+	if (uPackedVertices) {
+		position = vec3(inPackedVertex & 31u, (inPackedVertex >> 5) & 31u, (inPackedVertex >> 10) & 31u);
+	}
+
 	mat4 modelViewProj = uViewProjMatrix * uModelMatrix;
-	gl_Position = modelViewProj * vec4(inPosition, 1.0);
+	gl_Position = modelViewProj * vec4(position, 1.0);
 }
\ No newline at end of file
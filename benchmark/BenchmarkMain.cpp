@@ -0,0 +1,45 @@
+#include <cstring> // std::strcmp
+#include <iostream>
+
+#include "Benchmarks.hpp"
+
+namespace vox {
+
+volatile char benchmarkSink = 0;
+
+} // namespace vox
+
+namespace {
+
+struct NamedBenchmark final {
+	const char* name;
+	void (*func)();
+};
+
+const NamedBenchmark BENCHMARKS[] = {
+	{"lookup", vox::benchmarkChunkLookup},
+	{"access", vox::benchmarkChunkAccess},
+	{"meshing", vox::benchmarkMeshing},
+	{"generation", vox::benchmarkGeneration},
+	{"storage", vox::benchmarkStorage}
+};
+
+} // anonymous namespace
+
+// Runs all benchmarks, or only the ones whose names are given as arguments.
+int main(int argc, char* argv[])
+{
+	for (const NamedBenchmark& benchmark : BENCHMARKS) {
+		bool run = argc <= 1;
+		for (int i = 1; i < argc; i++) {
+			if (std::strcmp(argv[i], benchmark.name) == 0) run = true;
+		}
+		if (run) benchmark.func();
+	}
+
+	if (argc > 1) return 0;
+	std::cout << "\nAvailable benchmarks:";
+	for (const NamedBenchmark& benchmark : BENCHMARKS) std::cout << " " << benchmark.name;
+	std::cout << std::endl;
+	return 0;
+}
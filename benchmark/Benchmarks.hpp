@@ -0,0 +1,43 @@
+#pragma once
+#ifndef VOX_BENCHMARK_BENCHMARKS_HPP
+#define VOX_BENCHMARK_BENCHMARKS_HPP
+
+#include <cstddef> // size_t
+#include <cstdio>
+
+#include <sfz/util/StopWatch.hpp>
+
+namespace vox {
+
+using std::size_t;
+
+// Benchmark utilities
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+extern volatile char benchmarkSink; // Defined in BenchmarkMain.cpp
+
+/** @brief Prevents the optimizer from removing a computation whose result is otherwise unused. */
+template<typename T>
+inline void doNotOptimize(const T& value) noexcept
+{
+	benchmarkSink = *reinterpret_cast<const volatile char*>(&value);
+}
+
+inline void printBenchmarkHeader(const char* name) noexcept
+{
+	std::printf("\n%s\n", name);
+	std::printf("------------------------------------------------------------------------\n");
+}
+
+// Benchmarks
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkChunkLookup() noexcept;
+void benchmarkChunkAccess() noexcept;
+void benchmarkMeshing() noexcept;
+void benchmarkGeneration() noexcept;
+void benchmarkStorage() noexcept;
+
+} // namespace vox
+
+#endif
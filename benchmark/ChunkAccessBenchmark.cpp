@@ -0,0 +1,275 @@
+#include "Benchmarks.hpp"
+
+#include <cstring> // std::memcpy
+#include <random>
+#include <vector>
+
+#include "model/Chunk.hpp"
+#include "model/PackedChunk.hpp"
+#include "model/TerrainGeneration.hpp"
+
+namespace vox {
+
+// Legacy chunk
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+// The hierarchical chunk layout used before the flat Morton array, kept here as a baseline. The
+// bytes are laid out exactly as in Chunk, only the accessors differ.
+struct LegacyChunkPart2 {
+	Voxel mVoxel[2][2][2];
+};
+
+struct LegacyChunkPart4 {
+	LegacyChunkPart2 mChunkPart2s[2][2][2];
+};
+
+struct LegacyChunkPart8 {
+	LegacyChunkPart4 mChunkPart4s[2][2][2];
+};
+
+struct LegacyChunk {
+	LegacyChunkPart8 mChunkPart8s[2][2][2];
+
+	Voxel getVoxel(size_t x, size_t y, size_t z) const noexcept
+	{
+		size_t xi, yi, zi;
+
+		if (x < 8) xi = 0;
+		else xi = 1;
+		if (y < 8) yi = 0;
+		else yi = 1;
+		if (z < 8) zi = 0;
+		else zi = 1;
+		const LegacyChunkPart8* part8 = &mChunkPart8s[xi][yi][zi];
+
+		x %= 8;
+		y %= 8;
+		z %= 8;
+		if (x < 4) xi = 0;
+		else xi = 1;
+		if (y < 4) yi = 0;
+		else yi = 1;
+		if (z < 4) zi = 0;
+		else zi = 1;
+		const LegacyChunkPart4* part4 = &part8->mChunkPart4s[xi][yi][zi];
+
+		x %= 4;
+		y %= 4;
+		z %= 4;
+		if (x < 2) xi = 0;
+		else xi = 1;
+		if (y < 2) yi = 0;
+		else yi = 1;
+		if (z < 2) zi = 0;
+		else zi = 1;
+		const LegacyChunkPart2* part2 = &part4->mChunkPart2s[xi][yi][zi];
+
+		return part2->mVoxel[x % 2][y % 2][z % 2];
+	}
+
+	Voxel getVoxel(ChunkIndex i) const noexcept
+	{
+		const LegacyChunkPart8* part8 = &mChunkPart8s[i.part8X()][i.part8Y()][i.part8Z()];
+		const LegacyChunkPart4* part4 = &part8->mChunkPart4s[i.part4X()][i.part4Y()][i.part4Z()];
+		const LegacyChunkPart2* part2 = &part4->mChunkPart2s[i.part2X()][i.part2Y()][i.part2Z()];
+		return part2->mVoxel[i.voxelX()][i.voxelY()][i.voxelZ()];
+	}
+
+	static vec3 voxelOffset(ChunkIndex i) noexcept
+	{
+		return vec3{static_cast<float>(i.part8X()*8 + i.part4X()*4 + i.part2X()*2 + i.voxelX()),
+		            static_cast<float>(i.part8Y()*8 + i.part4Y()*4 + i.part2Y()*2 + i.voxelY()),
+		            static_cast<float>(i.part8Z()*8 + i.part4Z()*4 + i.part2Z()*2 + i.voxelZ())};
+	}
+};
+
+// Access patterns
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+template<typename ChunkT>
+size_t accessRandom(const ChunkT& chunk, const std::vector<vec3i>& positions) noexcept
+{
+	size_t sum = 0;
+	for (const vec3i& p : positions) {
+		sum += chunk.getVoxel((size_t)p[0], (size_t)p[1], (size_t)p[2]).mType;
+	}
+	return sum;
+}
+
+template<typename ChunkT>
+size_t accessLinear(const ChunkT& chunk) noexcept
+{
+	size_t sum = 0;
+	for (size_t x = 0; x < CHUNK_SIZE; x++) {
+		for (size_t y = 0; y < CHUNK_SIZE; y++) {
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				sum += chunk.getVoxel(x, y, z).mType;
+			}
+		}
+	}
+	return sum;
+}
+
+// Reads the 6 neighbours of every inner voxel, like the mesher does for face culling
+template<typename ChunkT>
+size_t accessNeighbours(const ChunkT& chunk) noexcept
+{
+	size_t sum = 0;
+	for (size_t x = 1; x < CHUNK_SIZE - 1; x++) {
+		for (size_t y = 1; y < CHUNK_SIZE - 1; y++) {
+			for (size_t z = 1; z < CHUNK_SIZE - 1; z++) {
+				sum += chunk.getVoxel(x - 1, y, z).mType + chunk.getVoxel(x + 1, y, z).mType +
+				       chunk.getVoxel(x, y - 1, z).mType + chunk.getVoxel(x, y + 1, z).mType +
+				       chunk.getVoxel(x, y, z - 1).mType + chunk.getVoxel(x, y, z + 1).mType;
+			}
+		}
+	}
+	return sum;
+}
+
+size_t iterateIndexLegacy(const LegacyChunk& chunk) noexcept
+{
+	float sum = 0.0f;
+	for (ChunkIndex i = ChunkIterateBegin; i != ChunkIterateEnd; i++) {
+		if (chunk.getVoxel(i).mType != VOXEL_AIR) sum += LegacyChunk::voxelOffset(i)[1];
+	}
+	return (size_t)sum;
+}
+
+size_t iterateIndex(const Chunk& chunk) noexcept
+{
+	float sum = 0.0f;
+	for (ChunkIndex i = ChunkIterateBegin; i != ChunkIterateEnd; i++) {
+		if (chunk.getVoxel(i).mType != VOXEL_AIR) sum += i.voxelOffset()[1];
+	}
+	return (size_t)sum;
+}
+
+size_t accessRows(const Chunk& chunk) noexcept
+{
+	size_t sum = 0;
+	Voxel row[CHUNK_SIZE];
+	for (size_t x = 0; x < CHUNK_SIZE; x++) {
+		for (size_t y = 0; y < CHUNK_SIZE; y++) {
+			chunk.getRow(x, y, row);
+			for (size_t z = 0; z < CHUNK_SIZE; z++) sum += row[z].mType;
+		}
+	}
+	return sum;
+}
+
+// Returns nanoseconds per voxel access of func run over all chunks
+template<typename ChunkT, typename Func>
+float timeAccess(const std::vector<ChunkT>& chunks, size_t accessesPerChunk, Func func) noexcept
+{
+	const size_t NUM_ROUNDS = 16;
+	size_t sum = 0;
+	sfz::StopWatch watch;
+	for (size_t round = 0; round < NUM_ROUNDS; round++) {
+		for (const ChunkT& chunk : chunks) sum += func(chunk);
+	}
+	float ns = watch.getTimeNanoSeconds();
+	doNotOptimize(sum);
+	return ns / float(NUM_ROUNDS * chunks.size() * accessesPerChunk);
+}
+
+void printRow(const char* pattern, float legacyNs, float flatNs) noexcept
+{
+	std::printf("%16s %12.3f %12.3f %10.2fx\n", pattern, legacyNs, flatNs, legacyNs / flatNs);
+}
+
+} // anonymous namespace
+
+// Chunk access benchmark
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkChunkAccess() noexcept
+{
+	// Generated terrain chunks, copied byte for byte into the legacy layout
+	std::vector<Chunk> chunks;
+	for (int x = -4; x <= 4; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -4; z <= 4; z++) {
+				chunks.push_back(generateChunk(vec3i{x, y, z}));
+			}
+		}
+	}
+	static_assert(sizeof(LegacyChunk) == sizeof(Chunk::mVoxels), "Layouts differ in size");
+	std::vector<LegacyChunk> legacyChunks(chunks.size());
+	for (size_t i = 0; i < chunks.size(); i++) {
+		std::memcpy(static_cast<void*>(&legacyChunks[i]), chunks[i].mVoxels, sizeof(LegacyChunk));
+	}
+
+	std::mt19937 rng{42};
+	std::uniform_int_distribution<int> coord{0, (int)CHUNK_SIZE - 1};
+	std::vector<vec3i> positions(1 << 12);
+	for (vec3i& p : positions) p = vec3i{coord(rng), coord(rng), coord(rng)};
+
+	const size_t INNER = CHUNK_SIZE - 2;
+	const size_t NEIGHBOUR_ACCESSES = INNER * INNER * INNER * 6;
+
+	printBenchmarkHeader("Chunk access: voxel reads, ns per voxel");
+	std::printf("%16s %12s %12s %11s\n", "pattern", "hierarchy", "flat morton", "speedup");
+
+	printRow("random xyz",
+	    timeAccess(legacyChunks, positions.size(),
+	               [&](const LegacyChunk& c) { return accessRandom(c, positions); }),
+	    timeAccess(chunks, positions.size(),
+	               [&](const Chunk& c) { return accessRandom(c, positions); }));
+	printRow("linear xyz",
+	    timeAccess(legacyChunks, CHUNK_NUM_VOXELS, accessLinear<LegacyChunk>),
+	    timeAccess(chunks, CHUNK_NUM_VOXELS, accessLinear<Chunk>));
+	printRow("neighbours",
+	    timeAccess(legacyChunks, NEIGHBOUR_ACCESSES, accessNeighbours<LegacyChunk>),
+	    timeAccess(chunks, NEIGHBOUR_ACCESSES, accessNeighbours<Chunk>));
+	printRow("index + offset",
+	    timeAccess(legacyChunks, CHUNK_NUM_VOXELS, iterateIndexLegacy),
+	    timeAccess(chunks, CHUNK_NUM_VOXELS, iterateIndex));
+	printRow("rows (getRow)",
+	    timeAccess(legacyChunks, CHUNK_NUM_VOXELS, accessLinear<LegacyChunk>),
+	    timeAccess(chunks, CHUNK_NUM_VOXELS, accessRows));
+
+	// Palette compressed chunks, the mixed (non-uniform) chunks are the interesting ones
+	std::vector<Chunk> mixedChunks;
+	for (const Chunk& chunk : chunks) {
+		if (!chunk.uniform()) mixedChunks.push_back(chunk);
+	}
+	std::vector<PackedChunk> packedChunks;
+	size_t numWithBits[9] = {}, packedSize = 0;
+	for (const Chunk& chunk : chunks) {
+		packedChunks.emplace_back(chunk);
+		numWithBits[packedChunks.back().bitsPerVoxel()]++;
+		packedSize += sizeof(PackedChunk) + packedChunks.back().dataSize();
+	}
+	std::vector<PackedChunk> packedMixed;
+	for (const Chunk& chunk : mixedChunks) packedMixed.emplace_back(chunk);
+
+	printBenchmarkHeader("Chunk access: palette compressed chunks");
+	std::printf("%zu chunks: %zu with 0 bits, %zu with 1, %zu with 2, %zu with 4, %zu with 8\n",
+	            chunks.size(), numWithBits[0], numWithBits[1], numWithBits[2], numWithBits[4],
+	            numWithBits[8]);
+	std::printf("Resident size: %.1f KiB packed, %.1f KiB as Chunk (%.1fx)\n",
+	            packedSize / 1024.0f, chunks.size() * sizeof(Chunk) / 1024.0f,
+	            float(chunks.size() * sizeof(Chunk)) / float(packedSize));
+
+	std::printf("%16s %12s %12s %11s\n", "mixed chunks", "flat morton", "packed", "slowdown");
+	const float flatRandom = timeAccess(mixedChunks, positions.size(),
+	    [&](const Chunk& c) { return accessRandom(c, positions); });
+	const float packedRandom = timeAccess(packedMixed, positions.size(),
+	    [&](const PackedChunk& c) { return accessRandom(c, positions); });
+	std::printf("%16s %12.3f %12.3f %10.2fx\n", "random xyz", flatRandom, packedRandom,
+	            packedRandom / flatRandom);
+
+	Chunk unpacked;
+	const float unpackNs = timeAccess(packedMixed, CHUNK_NUM_VOXELS,
+	    [&](const PackedChunk& c) { c.unpack(unpacked); return size_t(unpacked.mVoxels[7].mType); });
+	PackedChunk repacked;
+	const float packNs = timeAccess(mixedChunks, CHUNK_NUM_VOXELS,
+	    [&](const Chunk& c) { repacked.pack(c); return repacked.bitsPerVoxel(); });
+	std::printf("unpack %.2f us per chunk, pack %.2f us per chunk\n",
+	            unpackNs * CHUNK_NUM_VOXELS / 1000.0f, packNs * CHUNK_NUM_VOXELS / 1000.0f);
+}
+
+} // namespace vox
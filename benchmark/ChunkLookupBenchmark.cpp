@@ -0,0 +1,91 @@
+#include "Benchmarks.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "model/ChunkRing.hpp"
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+// The lookup World used before ChunkRing, kept here as a baseline.
+int linearChunkIndex(const vec3i* offsets, size_t numChunks, const vec3i& offset) noexcept
+{
+	for (int i = 0; i < (int)numChunks; i++) {
+		if (offsets[i] == offset) return i;
+	}
+	return -1;
+}
+
+std::vector<vec3i> chunkOffsetsInRange(int horizontalRange, int verticalRange) noexcept
+{
+	std::vector<vec3i> offsets;
+	for (int x = -horizontalRange; x <= horizontalRange; x++) {
+		for (int y = -verticalRange; y <= verticalRange; y++) {
+			for (int z = -horizontalRange; z <= horizontalRange; z++) {
+				offsets.push_back(vec3i{x, y, z});
+			}
+		}
+	}
+	return offsets;
+}
+
+} // anonymous namespace
+
+// Chunk lookup benchmark
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkChunkLookup() noexcept
+{
+	printBenchmarkHeader("Chunk lookup: offset -> chunk index, ns per query");
+	std::printf("%6s %6s %8s %14s %14s\n", "hRange", "vRange", "chunks", "ChunkRing", "linear scan");
+
+	const size_t NUM_QUERIES = 1 << 20;
+	const int RANGES[] = {1, 2, 4, 8, 12, 16};
+	std::mt19937 rng{42};
+
+	for (int hRange : RANGES) {
+		int vRange = hRange / 2;
+		std::vector<vec3i> offsets = chunkOffsetsInRange(hRange, vRange);
+		ChunkRing ring{hRange, vRange};
+		std::vector<vec3i> slotOffsets(ring.numSlots());
+		for (const vec3i& offset : offsets) {
+			slotOffsets[ring.slot(offset)] = offset;
+		}
+
+		// Queries are mostly hits, with some misses just outside the loaded range
+		std::uniform_int_distribution<int> hDist{-hRange - 1, hRange + 1};
+		std::uniform_int_distribution<int> vDist{-vRange - 1, vRange + 1};
+		std::vector<vec3i> queries(NUM_QUERIES);
+		for (vec3i& q : queries) q = vec3i{hDist(rng), vDist(rng), hDist(rng)};
+
+		sfz::StopWatch watch;
+		long long sum = 0;
+		for (const vec3i& q : queries) {
+			// Same as World::chunkIndex(), the slot is only valid if it holds the queried offset
+			size_t index = ring.slot(q);
+			sum += slotOffsets[index] == q ? int(index) : -1;
+		}
+		float ringNs = watch.getTimeNanoSeconds() / float(NUM_QUERIES);
+		doNotOptimize(sum);
+
+		// The linear scan is too slow to run all queries for large ranges
+		const size_t numLinearQueries = NUM_QUERIES / offsets.size() + 1024;
+		watch.start();
+		sum = 0;
+		for (size_t i = 0; i < numLinearQueries; i++) {
+			sum += linearChunkIndex(offsets.data(), offsets.size(), queries[i]);
+		}
+		float linearNs = watch.getTimeNanoSeconds() / float(numLinearQueries);
+		doNotOptimize(sum);
+
+		std::printf("%6i %6i %8zu %14.2f %14.2f\n", hRange, vRange, offsets.size(), ringNs, linearNs);
+	}
+}
+
+} // namespace vox
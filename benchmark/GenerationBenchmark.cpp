@@ -0,0 +1,217 @@
+#include "Benchmarks.hpp"
+
+#include <cstring> // std::memcmp
+#include <thread>
+#include <vector>
+
+#include "model/Noise.hpp"
+#include "model/TerrainGeneration.hpp"
+#include "model/TerrainGenerator.hpp"
+
+namespace vox {
+
+// Per voxel baseline
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+// generateChunk() as it was before heightmaps, calling generateVoxel() for each voxel
+Chunk generateChunkPerVoxel(const vec3i& offset) noexcept
+{
+	const vec3i worldOffset = offset * static_cast<int>(CHUNK_SIZE);
+	Chunk chunk;
+	for (int y = 0; y < (int)CHUNK_SIZE; y++) {
+		for (int z = 0; z < (int)CHUNK_SIZE; z++) {
+			for (int x = 0; x < (int)CHUNK_SIZE; x++) {
+				chunk.setVoxel((size_t)x, (size_t)y, (size_t)z,
+				               generateVoxel(worldOffset + vec3i{x, y, z}));
+			}
+		}
+	}
+	return chunk;
+}
+
+} // anonymous namespace
+
+// Generation benchmark
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkGeneration() noexcept
+{
+	printBenchmarkHeader("Terrain generation: generateChunk() for the chunks World loads at range 8/4");
+
+	const int H_RANGE = 8, V_RANGE = 4;
+	const int NUM_PASSES = 5;
+	std::vector<vec3i> offsets;
+	for (int x = -H_RANGE; x <= H_RANGE; x++) {
+		for (int z = -H_RANGE; z <= H_RANGE; z++) {
+			for (int y = -V_RANGE; y <= V_RANGE; y++) {
+				offsets.push_back(vec3i{x, y, z});
+			}
+		}
+	}
+	const size_t numChunks = offsets.size() * NUM_PASSES;
+
+	std::vector<Chunk> reference(offsets.size());
+	std::vector<Chunk> generated(offsets.size());
+	std::printf("%22s %8s %14s %14s\n", "method", "chunks", "chunks/s", "mismatches");
+
+	// Before: every voxel evaluates the height function
+	sfz::StopWatch watch;
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (size_t i = 0; i < offsets.size(); i++) {
+			reference[i] = generateChunkPerVoxel(offsets[i]);
+		}
+	}
+	float seconds = watch.getTimeSeconds();
+	doNotOptimize(reference.back());
+	std::printf("%22s %8zu %14.0f %14s\n", "per voxel", numChunks, numChunks / seconds, "-");
+
+	auto countMismatches = [&]() {
+		size_t numMismatches = 0;
+		for (size_t i = 0; i < offsets.size(); i++) {
+			bool equal = std::memcmp(reference[i].mVoxels, generated[i].mVoxels,
+			                         sizeof(Chunk::mVoxels)) == 0;
+			equal = equal && reference[i].occupancy() == generated[i].occupancy();
+			if (!equal) numMismatches++;
+		}
+		return numMismatches;
+	};
+
+	// After: one heightmap per chunk, as generateChunk(offset) does
+	watch.start();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (size_t i = 0; i < offsets.size(); i++) {
+			generated[i] = generateChunk(offsets[i]);
+		}
+	}
+	seconds = watch.getTimeSeconds();
+	doNotOptimize(generated.back());
+	std::printf("%22s %8zu %14.0f %14zu\n", "heightmap per chunk", numChunks, numChunks / seconds,
+	            countMismatches());
+
+	// After: one heightmap per column of chunks, offsets are ordered by column
+	watch.start();
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		ChunkHeightmap heightmap;
+		for (size_t i = 0; i < offsets.size(); i++) {
+			if (i == 0 || offsets[i][0] != offsets[i-1][0] || offsets[i][2] != offsets[i-1][2]) {
+				heightmap = generateHeightmap(offsets[i][0], offsets[i][2]);
+			}
+			generated[i] = generateChunk(heightmap, offsets[i][1]);
+		}
+	}
+	seconds = watch.getTimeSeconds();
+	doNotOptimize(generated.back());
+	std::printf("%22s %8zu %14.0f %14zu\n", "heightmap per column", numChunks, numChunks / seconds,
+	            countMismatches());
+
+	size_t numSkipped = 0;
+	for (const Chunk& chunk : generated) {
+		if (chunk.occupancy() == Occupancy::AIR) numSkipped++;
+	}
+	std::printf("%zu of %zu chunks are entirely above or below the surface\n", numSkipped,
+	            offsets.size());
+
+	// Noise kernels, with the octaves used by the noise terrain's heights and caves
+	printBenchmarkHeader("Terrain generation: fractal value noise, rows of 16 vs scalar reference");
+	std::printf("%22s %14s %14s %10s %14s\n", "noise", "scalar Mpt/s", "rows Mpt/s", "speedup",
+	            "mismatches");
+	const FractalNoise NOISES[2] = {FractalNoise{1u, 5, 7}, FractalNoise{2u, 2, 5}};
+	const char* const NOISE_NAMES[2] = {"2D, 5 octaves", "3D, 2 octaves"};
+	const int NOISE_RANGE = 128;
+	std::vector<float> scalarValues(NOISE_RANGE * NOISE_RANGE * NOISE_ROW_SIZE);
+	std::vector<float> rowValues(scalarValues.size());
+	for (size_t n = 0; n < 2; n++) {
+		const FractalNoise& noise = NOISES[n];
+		const bool is3D = n == 1;
+
+		watch.start();
+		size_t i = 0;
+		for (int x = -NOISE_RANGE / 2; x < NOISE_RANGE / 2; x++) {
+			for (int y = -NOISE_RANGE / 2; y < NOISE_RANGE / 2; y++) {
+				for (int z = 0; z < (int)NOISE_ROW_SIZE; z++, i++) {
+					const int rowZ = y * (int)NOISE_ROW_SIZE + z;
+					scalarValues[i] = is3D ? fractalNoise3Scalar(noise, x, y, z) :
+					                         fractalNoise2Scalar(noise, x, rowZ);
+				}
+			}
+		}
+		float scalarSeconds = watch.getTimeSeconds();
+		doNotOptimize(scalarValues.back());
+
+		watch.start();
+		i = 0;
+		for (int x = -NOISE_RANGE / 2; x < NOISE_RANGE / 2; x++) {
+			for (int y = -NOISE_RANGE / 2; y < NOISE_RANGE / 2; y++, i += NOISE_ROW_SIZE) {
+				if (is3D) fractalNoise3(noise, x, y, 0, &rowValues[i]);
+				else fractalNoise2(noise, x, y * (int)NOISE_ROW_SIZE, &rowValues[i]);
+			}
+		}
+		float rowSeconds = watch.getTimeSeconds();
+		doNotOptimize(rowValues.back());
+
+		size_t numMismatches = 0;
+		for (i = 0; i < rowValues.size(); i++) {
+			if (std::memcmp(&scalarValues[i], &rowValues[i], sizeof(float)) != 0) numMismatches++;
+		}
+		float millionPoints = float(rowValues.size()) / 1000000.0f;
+		std::printf("%22s %14.1f %14.1f %9.2fx %14zu\n", NOISE_NAMES[n],
+		            millionPoints / scalarSeconds, millionPoints / rowSeconds,
+		            scalarSeconds / rowSeconds, numMismatches);
+	}
+	std::printf("SIMD kernels: %s\n", noiseUsesSimd() ? "SSE2" : "none, rows use the scalar code");
+
+	// Generators, one heightmap per column of chunks like ChunkLoader
+	printBenchmarkHeader("Terrain generation: TerrainGenerator, chunks World loads at range 8/4");
+	std::printf("%22s %8s %14s %14s\n", "generator", "chunks", "chunks/s", "uniform");
+	TerrainSettings settings[3];
+	settings[1].type = TerrainType::NOISE;
+	settings[2].type = TerrainType::NOISE;
+	settings[2].caves = true;
+	const char* const GENERATOR_NAMES[3] = {"paraboloid", "noise", "noise with caves"};
+	for (size_t g = 0; g < 3; g++) {
+		unique_ptr<TerrainGenerator> generator = createTerrainGenerator(settings[g]);
+		watch.start();
+		for (int pass = 0; pass < NUM_PASSES; pass++) {
+			ChunkHeightmap heightmap;
+			for (size_t i = 0; i < offsets.size(); i++) {
+				if (i == 0 || offsets[i][0] != offsets[i-1][0] || offsets[i][2] != offsets[i-1][2]) {
+					heightmap = generator->generateHeightmap(offsets[i][0], offsets[i][2]);
+				}
+				generated[i] = generator->generateChunk(heightmap, offsets[i]);
+			}
+		}
+		seconds = watch.getTimeSeconds();
+		doNotOptimize(generated.back());
+
+		size_t numUniform = 0;
+		for (const Chunk& chunk : generated) {
+			if (chunk.uniform()) numUniform++;
+		}
+		std::printf("%22s %8zu %14.0f %14zu\n", GENERATOR_NAMES[g], numChunks, numChunks / seconds,
+		            numUniform);
+	}
+
+	// Batch generation, compared voxel for voxel with the single threaded result
+	printBenchmarkHeader("Terrain generation: TerrainGenerator::generateChunks(), noise with caves");
+	std::printf("%22s %8s %14s %10s %14s\n", "threads", "chunks", "chunks/s", "speedup",
+	            "mismatches");
+	unique_ptr<TerrainGenerator> generator = createTerrainGenerator(settings[2]);
+	float singleThreadSeconds = 0.0f;
+	for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2) {
+		std::vector<Chunk>& out = numThreads == 1 ? reference : generated;
+		watch.start();
+		generator->generateChunks(offsets.data(), out.data(), offsets.size(), numThreads);
+		seconds = watch.getTimeSeconds();
+		doNotOptimize(out.back());
+		if (numThreads == 1) singleThreadSeconds = seconds;
+
+		std::printf("%22zu %8zu %14.0f %9.2fx %14zu\n", numThreads, offsets.size(),
+		            offsets.size() / seconds, singleThreadSeconds / seconds,
+		            numThreads == 1 ? size_t(0) : countMismatches());
+	}
+	std::printf("Hardware threads: %u\n", std::thread::hardware_concurrency());
+}
+
+} // namespace vox
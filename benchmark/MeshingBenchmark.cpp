@@ -0,0 +1,129 @@
+#include "Benchmarks.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "model/ChunkMeshBuilder.hpp"
+#include "model/ChunkMesher.hpp"
+#include "model/ChunkRing.hpp"
+#include "model/TerrainGeneration.hpp"
+
+namespace vox {
+
+// Meshing benchmark
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkMeshing() noexcept
+{
+	printBenchmarkHeader("Chunk meshing: ChunkMeshBuilder on generated terrain, single thread");
+
+	// The chunks World loads at range 8/4, neighbours outside the range count as air like in World
+	const int H_RANGE = 8, V_RANGE = 4;
+	const vec3i NEIGHBOUR_DIRECTIONS[6] = {
+		vec3i{-1, 0, 0}, vec3i{1, 0, 0}, vec3i{0, -1, 0}, vec3i{0, 1, 0}, vec3i{0, 0, -1}, vec3i{0, 0, 1}
+	};
+	const vec3i min{-H_RANGE, -V_RANGE, -H_RANGE}, max{H_RANGE, V_RANGE, H_RANGE};
+	ChunkRing ring{H_RANGE, V_RANGE};
+	std::vector<Chunk> chunks(ring.numSlots());
+	std::vector<vec3i> offsets;
+	for (int x = min[0]; x <= max[0]; x++) {
+		for (int y = min[1]; y <= max[1]; y++) {
+			for (int z = min[2]; z <= max[2]; z++) {
+				offsets.push_back(vec3i{x, y, z});
+				chunks[ring.slot(offsets.back())] = generateChunk(offsets.back());
+			}
+		}
+	}
+
+	std::printf("%8s %8s %14s %14s %14s\n", "mode", "chunks", "chunks/s", "faces/chunk", "bytes/chunk");
+
+	// Neighbours of each chunk in the same layout as in World, nullptr if outside the range
+	std::vector<const Chunk*> neighbourPtrs(offsets.size() * 6);
+	for (size_t i = 0; i < offsets.size(); i++) {
+		for (size_t dir = 0; dir < 6; dir++) {
+			vec3i n = offsets[i] + NEIGHBOUR_DIRECTIONS[dir];
+			bool inside = min[0] <= n[0] && n[0] <= max[0] && min[1] <= n[1] && n[1] <= max[1] &&
+			              min[2] <= n[2] && n[2] <= max[2];
+			neighbourPtrs[i*6 + dir] = inside ? &chunks[ring.slot(n)] : nullptr;
+		}
+	}
+
+	ChunkMeshBuilder builder;
+	const MeshingMode MODES[] = {MeshingMode::CULLED, MeshingMode::GREEDY};
+	const char* const MODE_NAMES[] = {"culled", "greedy"};
+	for (size_t m = 0; m < 2; m++) {
+		size_t numFaces = 0, numBytes = 0;
+		sfz::StopWatch watch;
+		for (size_t i = 0; i < offsets.size(); i++) {
+			builder.build(chunks[ring.slot(offsets[i])], &neighbourPtrs[i*6], MODES[m]);
+			numFaces += builder.numFaces();
+			numBytes += builder.vertexDataSize();
+		}
+		float seconds = watch.getTimeSeconds();
+		doNotOptimize(numFaces);
+
+		float numChunks = float(offsets.size());
+		std::printf("%8s %8zu %14.0f %14.1f %14.1f\n", MODE_NAMES[m], offsets.size(),
+		            numChunks / seconds, float(numFaces) / numChunks, float(numBytes) / numChunks);
+	}
+
+	// What a single voxel edit costs: rebuilding the whole mesh or only the affected segment
+	printBenchmarkHeader("Chunk meshing: rebuild after an edit, us per chunk");
+	std::printf("%8s %14s %14s\n", "mode", "full mesh", "one segment");
+	for (size_t m = 0; m < 2; m++) {
+		float times[2];
+		const uint8_t SEGMENT_MASKS[2] = {CHUNK_MESH_ALL_SEGMENTS, 1};
+		for (size_t s = 0; s < 2; s++) {
+			size_t numFaces = 0;
+			sfz::StopWatch watch;
+			for (size_t i = 0; i < offsets.size(); i++) {
+				builder.build(chunks[ring.slot(offsets[i])], &neighbourPtrs[i*6], MODES[m], SEGMENT_MASKS[s]);
+				numFaces += builder.numFaces();
+			}
+			times[s] = watch.getTimeNanoSeconds() / 1000.0f / float(offsets.size());
+			doNotOptimize(numFaces);
+		}
+		std::printf("%8s %14.2f %14.2f\n", MODE_NAMES[m], times[0], times[1]);
+	}
+
+	// Same chunks through ChunkMesher, with shared snapshots and results copied out like World does
+	printBenchmarkHeader("Chunk meshing: ChunkMesher worker pool, greedy mode");
+	std::printf("%8s %14s %10s\n", "threads", "chunks/s", "speedup");
+
+	std::vector<std::shared_ptr<const Chunk>> snapshots;
+	for (const Chunk& chunk : chunks) snapshots.push_back(std::make_shared<Chunk>(chunk));
+	std::vector<MeshJob> jobs(offsets.size());
+	for (size_t i = 0; i < offsets.size(); i++) {
+		MeshJob& job = jobs[i];
+		job.index = i;
+		job.version = 0;
+		job.mode = MeshingMode::GREEDY;
+		job.segmentMask = CHUNK_MESH_ALL_SEGMENTS;
+		job.chunk = snapshots[ring.slot(offsets[i])];
+		for (size_t dir = 0; dir < 6; dir++) {
+			const Chunk* neighbour = neighbourPtrs[i*6 + dir];
+			if (neighbour == nullptr) continue;
+			job.neighbours[dir] = snapshots[size_t(neighbour - chunks.data())];
+		}
+	}
+
+	size_t maxNumThreads = std::thread::hardware_concurrency();
+	if (maxNumThreads == 0) maxNumThreads = 1;
+	float singleThreadRate = 0.0f;
+	std::vector<MeshedChunk> meshed;
+	for (size_t numThreads = 1; numThreads <= maxNumThreads; numThreads *= 2) {
+		ChunkMesher mesher{numThreads};
+		meshed.clear();
+		sfz::StopWatch watch;
+		for (const MeshJob& job : jobs) mesher.request(job);
+		while (meshed.size() < jobs.size()) {
+			if (mesher.takeFinished(meshed) == 0) std::this_thread::yield();
+		}
+		float rate = float(jobs.size()) / watch.getTimeSeconds();
+		if (numThreads == 1) singleThreadRate = rate;
+		std::printf("%8zu %14.0f %10.2f\n", numThreads, rate, rate / singleThreadRate);
+	}
+}
+
+} // namespace vox
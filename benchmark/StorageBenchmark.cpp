@@ -0,0 +1,369 @@
+#include "Benchmarks.hpp"
+
+#include <cstdint> // uint8_t, uint32_t
+#include <cstring> // std::memcmp
+#include <string>
+#include <vector>
+
+#include <sfz/util/IO.hpp>
+
+#include "io/ChunkIO.hpp"
+
+namespace vox {
+
+// One file per chunk baseline
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+const char* const WORLD_NAME = "benchmark_storage";
+
+std::string legacyFilename(const vec3i& offset) noexcept
+{
+	return basePath() + WORLD_NAME + "/chunk__" + std::to_string(offset[0]) + "x_"
+	     + std::to_string(offset[1]) + "y_" + std::to_string(offset[2]) + "z.bin";
+}
+
+// The chunk files written before region files, all voxels of the chunk. Returns the size of the
+// file, 0 if it couldn't be written.
+size_t writeLegacyChunkFile(const Chunk& chunk, const vec3i& offset) noexcept
+{
+	const uint8_t* data = &chunk.mVoxels[0].mType;
+	bool success = sfz::writeBinaryFile(legacyFilename(offset).c_str(), data, CHUNK_NUM_VOXELS);
+	return success ? CHUNK_NUM_VOXELS : 0;
+}
+
+// readChunk() as it was before region files, one stat, open and read per chunk
+bool readLegacyChunkFile(Chunk& chunk, const vec3i& offset) noexcept
+{
+	std::string filePath = legacyFilename(offset);
+	if (!sfz::directoryExists(filePath.c_str())) return false;
+
+	std::FILE* chunkFile = std::fopen(filePath.c_str(), "rb");
+	if (chunkFile == NULL) return false;
+	size_t size = std::fread(static_cast<void*>(chunk.mVoxels), 1, CHUNK_NUM_VOXELS, chunkFile);
+	std::fclose(chunkFile);
+	if (size != CHUNK_NUM_VOXELS) return false;
+	chunk.updateOccupancy();
+	return true;
+}
+
+std::string worldPath() noexcept
+{
+	return basePath() + WORLD_NAME + "/";
+}
+
+size_t worldFilesSize() noexcept
+{
+	size_t size = 0;
+	for (const std::string& name : listFiles(worldPath())) {
+		size += (size_t)sfz::sizeofFile((worldPath() + name).c_str());
+	}
+	return size;
+}
+
+void removeWorldFiles() noexcept
+{
+	for (const std::string& name : listFiles(worldPath())) {
+		sfz::deleteFile((worldPath() + name).c_str());
+	}
+	sfz::deleteDirectory(worldPath().c_str());
+}
+
+// Kinds of modified chunks, cycled through by the stored chunks
+const size_t NUM_EDIT_KINDS = 3;
+const char* const EDIT_KIND_NAMES[NUM_EDIT_KINDS] = {"64 edits", "lower half filled",
+                                                     "random voxels"};
+
+Chunk editChunk(const Chunk& generated, size_t kind, uint32_t& random) noexcept
+{
+	Chunk chunk = generated;
+	for (size_t i = 0; i < CHUNK_NUM_VOXELS; i++) {
+		random = random * 1664525u + 1013904223u;
+		const Voxel voxel{uint8_t(1 + (random >> 28) % 4)};
+		if (kind == 0 && i < 64) chunk.mVoxels[(random >> 8) % CHUNK_NUM_VOXELS] = voxel;
+		if (kind == 2) chunk.mVoxels[i] = voxel;
+	}
+	if (kind == 1) {
+		for (size_t y = 0; y < CHUNK_SIZE / 2; y++) {
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				for (size_t x = 0; x < CHUNK_SIZE; x++) chunk.setVoxel(x, y, z, Voxel{4});
+			}
+		}
+	}
+	chunk.updateOccupancy();
+	return chunk;
+}
+
+} // anonymous namespace
+
+// Storage benchmark
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void benchmarkStorage() noexcept
+{
+	printBenchmarkHeader("Chunk storage: loading the chunks World loads at range 8/4, 1 in 4 stored");
+
+	const int H_RANGE = 8, V_RANGE = 4;
+	const int NUM_PASSES = 5;
+	std::vector<vec3i> offsets;
+	for (int x = -H_RANGE; x <= H_RANGE; x++) {
+		for (int z = -H_RANGE; z <= H_RANGE; z++) {
+			for (int y = -V_RANGE; y <= V_RANGE; y++) {
+				offsets.push_back(vec3i{x, y, z});
+			}
+		}
+	}
+	const size_t numLoads = offsets.size() * NUM_PASSES;
+
+	// Every 4th chunk is modified
+	removeWorldFiles();
+	sfz::createDirectory(worldPath().c_str());
+	unique_ptr<TerrainGenerator> generator = createTerrainGenerator(TerrainSettings{});
+	std::vector<size_t> stored;
+	std::vector<Chunk> edited;
+	uint32_t random = 1u;
+	size_t legacySizes[NUM_EDIT_KINDS] = {0, 0, 0};
+	for (size_t i = 0; i < offsets.size(); i += 4) {
+		const Chunk generated = generator->generateChunk(offsets[i]);
+		const size_t kind = stored.size() % NUM_EDIT_KINDS;
+		Chunk chunk = editChunk(generated, kind, random);
+		size_t size = writeLegacyChunkFile(chunk, offsets[i]);
+		if (size == 0) continue;
+		legacySizes[kind] += size;
+		stored.push_back(i);
+		edited.push_back(chunk);
+	}
+	const size_t legacyFilesSize = worldFilesSize();
+
+	std::vector<Chunk> reference(offsets.size());
+	std::vector<Chunk> loaded(offsets.size());
+	std::vector<bool> referenceStored(offsets.size()), loadedStored(offsets.size());
+	std::printf("%22s %8s %14s %14s\n", "layout", "loads", "chunks/s", "mismatches");
+
+	// Before: one file per chunk
+	sfz::StopWatch watch;
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		for (size_t i = 0; i < offsets.size(); i++) {
+			referenceStored[i] = readLegacyChunkFile(reference[i], offsets[i]);
+		}
+	}
+	float seconds = watch.getTimeSeconds();
+	doNotOptimize(reference.back());
+	std::printf("%22s %8zu %14.0f %14s\n", "file per chunk", numLoads, numLoads / seconds, "-");
+
+	// The region files are closed before they are removed
+	{
+		ChunkStorage storage{WORLD_NAME};
+		watch.start();
+		size_t numConverted = storage.convertChunkFiles();
+		float convertSeconds = watch.getTimeSeconds();
+
+		auto countMismatches = [&]() {
+			size_t numMismatches = 0;
+			for (size_t i = 0; i < offsets.size(); i++) {
+				bool equal = referenceStored[i] == loadedStored[i];
+				equal = equal && (!loadedStored[i] || std::memcmp(reference[i].mVoxels,
+				                  loaded[i].mVoxels, sizeof(Chunk::mVoxels)) == 0);
+				if (!equal) numMismatches++;
+			}
+			return numMismatches;
+		};
+
+		// After: region files decoded from their mapping, the first pass includes opening them
+		watch.start();
+		for (int pass = 0; pass < NUM_PASSES; pass++) {
+			for (size_t i = 0; i < offsets.size(); i++) {
+				loadedStored[i] = storage.readChunk(loaded[i], offsets[i], *generator);
+			}
+		}
+		seconds = watch.getTimeSeconds();
+		doNotOptimize(loaded.back());
+		std::printf("%22s %8zu %14.0f %14zu\n", "region files, mapped", numLoads,
+		            numLoads / seconds, countMismatches());
+
+		// Unexplored terrain, none of the chunks or their regions were ever stored
+		size_t numFound = 0;
+		watch.start();
+		for (int pass = 0; pass < NUM_PASSES; pass++) {
+			for (size_t i = 0; i < offsets.size(); i++) {
+				const vec3i farOffset = offsets[i] + vec3i{1000, 0, 1000};
+				if (storage.readChunk(loaded[i], farOffset, *generator)) numFound++;
+			}
+		}
+		seconds = watch.getTimeSeconds();
+		std::printf("%22s %8zu %14.0f %14zu\n", "never stored", numLoads, numLoads / seconds,
+		            numFound);
+
+		// Region files read into a buffer with fread(), as before they were mapped
+		std::vector<unique_ptr<RegionFile>> regions;
+		std::vector<vec3i> regionOffsets;
+		watch.start();
+		for (int pass = 0; pass < NUM_PASSES; pass++) {
+			for (size_t i = 0; i < offsets.size(); i++) {
+				const vec3i& o = offsets[i];
+				const vec3i regionOffset{o[0] >> 4, o[1] >> 4, o[2] >> 4};
+				size_t r = 0;
+				while (r < regionOffsets.size() && regionOffsets[r] != regionOffset) r++;
+				if (r == regions.size()) {
+					regionOffsets.push_back(regionOffset);
+					regions.emplace_back(new RegionFile{});
+					regions.back()->open(worldPath() + "region__" + std::to_string(regionOffset[0])
+					    + "x_" + std::to_string(regionOffset[1]) + "y_"
+					    + std::to_string(regionOffset[2]) + "z.bin", false);
+				}
+				uint8_t buffer[REGION_MAX_CHUNK_SIZE];
+				size_t size = regions[r]->read(RegionFile::chunkIndex(o[0], o[1], o[2]), buffer);
+				loadedStored[i] = size != 0 &&
+				                  decodeChunk(loaded[i], buffer, size, offsets[i], *generator);
+			}
+		}
+		seconds = watch.getTimeSeconds();
+		doNotOptimize(loaded.back());
+		std::printf("%22s %8zu %14.0f %14zu\n", "region files, fread", numLoads,
+		            numLoads / seconds, countMismatches());
+		const size_t numFiles = listFiles(worldPath()).size();
+		std::printf("Converted %zu of %zu chunk files in %.1f ms, %zu world files remain\n",
+		            numConverted, stored.size(), convertSeconds * 1000.0f, numFiles);
+		std::printf("On disk: %zu bytes of chunk files, %zu bytes of region files\n",
+		            legacyFilesSize, worldFilesSize());
+	}
+	removeWorldFiles();
+
+	// Codecs, per kind of modified chunk
+	printBenchmarkHeader("Chunk storage: encodeChunk() and decodeChunk() per kind of modified chunk");
+	std::printf("%22s %8s %12s %12s %8s %16s\n", "chunks", "stored", "chunk file B", "encoded B",
+	            "ratio", "decode chunks/s");
+	std::vector<uint8_t> encoded(stored.size() * CHUNK_MAX_ENCODED_SIZE);
+	std::vector<size_t> encodedSizes(stored.size());
+	for (size_t kind = 0; kind < NUM_EDIT_KINDS; kind++) {
+		size_t numChunks = 0, encodedSize = 0;
+		for (size_t j = kind; j < stored.size(); j += NUM_EDIT_KINDS, numChunks++) {
+			const Chunk generated = generator->generateChunk(offsets[stored[j]]);
+			encodedSizes[j] = encodeChunk(edited[j], generated, &encoded[j * CHUNK_MAX_ENCODED_SIZE]);
+			encodedSize += encodedSizes[j];
+		}
+
+		size_t numMismatches = 0;
+		watch.start();
+		for (int pass = 0; pass < NUM_PASSES; pass++) {
+			for (size_t j = kind; j < stored.size(); j += NUM_EDIT_KINDS) {
+				decodeChunk(loaded[j], &encoded[j * CHUNK_MAX_ENCODED_SIZE], encodedSizes[j],
+				            offsets[stored[j]], *generator);
+			}
+		}
+		seconds = watch.getTimeSeconds();
+		doNotOptimize(loaded.back());
+		for (size_t j = kind; j < stored.size(); j += NUM_EDIT_KINDS) {
+			if (std::memcmp(loaded[j].mVoxels, edited[j].mVoxels, sizeof(Chunk::mVoxels)) != 0) {
+				numMismatches++;
+			}
+		}
+
+		std::printf("%22s %8zu %12zu %12zu %7.1fx %16.0f%s\n", EDIT_KIND_NAMES[kind], numChunks,
+		            legacySizes[kind], encodedSize, float(legacySizes[kind]) / float(encodedSize),
+		            (numChunks * NUM_PASSES) / seconds, numMismatches == 0 ? "" : " MISMATCH");
+	}
+
+	// Writes, every edit changes one voxel of one of a few chunks the player is working on
+	printBenchmarkHeader("Chunk storage: writing 2048 single voxel edits of 32 chunks");
+	const size_t NUM_EDITS = 2048, NUM_EDITED_CHUNKS = 32, EDITS_PER_BATCH = 256;
+	std::vector<vec3i> editOffsets;
+	std::vector<Chunk> generatedChunks, editedChunks;
+	for (size_t i = 0; i < NUM_EDITED_CHUNKS; i++) {
+		editOffsets.push_back(vec3i{int(i % 8), 0, int(i / 8)});
+		generatedChunks.push_back(generator->generateChunk(editOffsets.back()));
+	}
+	std::vector<uint32_t> edits(NUM_EDITS);
+	for (uint32_t& edit : edits) {
+		random = random * 1664525u + 1013904223u;
+		edit = random;
+	}
+	auto applyEdit = [&](size_t j) {
+		const size_t target = (edits[j] >> 24) % NUM_EDITED_CHUNKS;
+		editedChunks[target].mVoxels[edits[j] % CHUNK_NUM_VOXELS] = Voxel{uint8_t(1 + j % 4)};
+		return target;
+	};
+	auto countWriteMismatches = [&]() {
+		ChunkStorage storage{WORLD_NAME};
+		size_t numMismatches = 0;
+		for (size_t i = 0; i < NUM_EDITED_CHUNKS; i++) {
+			Chunk chunk;
+			if (!storage.readChunk(chunk, editOffsets[i], *generator) ||
+			    std::memcmp(chunk.mVoxels, editedChunks[i].mVoxels, sizeof(Chunk::mVoxels)) != 0) {
+				numMismatches++;
+			}
+		}
+		return numMismatches;
+	};
+	std::printf("%22s %8s %12s %14s %14s\n", "writes", "edits", "ms", "edits/s", "mismatches");
+
+	// Before: every edit rewritten in place in the region file, not crash safe
+	removeWorldFiles();
+	sfz::createDirectory(worldPath().c_str());
+	editedChunks = generatedChunks;
+	{
+		RegionFile file;
+		file.open(worldPath() + "region__0x_0y_0z.bin", true);
+		uint8_t buffer[CHUNK_MAX_ENCODED_SIZE];
+		watch.start();
+		for (size_t j = 0; j < NUM_EDITS; j++) {
+			const size_t target = applyEdit(j);
+			const size_t size = encodeChunk(editedChunks[target], generatedChunks[target], buffer);
+			const vec3i& o = editOffsets[target];
+			const size_t index = RegionFile::chunkIndex(o[0], o[1], o[2]);
+			if (size == 0) file.erase(index);
+			else file.write(index, buffer, size);
+		}
+		seconds = watch.getTimeSeconds();
+	}
+	std::printf("%22s %8zu %12.1f %14.0f %14zu\n", "per edit, no journal", NUM_EDITS,
+	            seconds * 1000.0f, NUM_EDITS / seconds, countWriteMismatches());
+
+	// One journal frame and sync per edit
+	removeWorldFiles();
+	editedChunks = generatedChunks;
+	{
+		ChunkStorage storage{WORLD_NAME};
+		watch.start();
+		for (size_t j = 0; j < NUM_EDITS; j++) {
+			const size_t target = applyEdit(j);
+			storage.writeChunk(editedChunks[target], generatedChunks[target], editOffsets[target]);
+		}
+		storage.checkpoint();
+		seconds = watch.getTimeSeconds();
+	}
+	std::printf("%22s %8zu %12.1f %14.0f %14zu\n", "per edit, journaled", NUM_EDITS,
+	            seconds * 1000.0f, NUM_EDITS / seconds, countWriteMismatches());
+
+	// Edits coalesced like ChunkWriter does, one frame for the chunks modified in each window
+	removeWorldFiles();
+	editedChunks = generatedChunks;
+	{
+		ChunkStorage storage{WORLD_NAME};
+		std::vector<bool> modified(NUM_EDITED_CHUNKS, false);
+		std::vector<EncodedChunk> batch;
+		watch.start();
+		for (size_t j = 0; j < NUM_EDITS; j++) {
+			modified[applyEdit(j)] = true;
+			if ((j + 1) % EDITS_PER_BATCH != 0 && j + 1 != NUM_EDITS) continue;
+			batch.clear();
+			for (size_t i = 0; i < NUM_EDITED_CHUNKS; i++) {
+				if (!modified[i]) continue;
+				modified[i] = false;
+				batch.emplace_back();
+				batch.back().offset = editOffsets[i];
+				batch.back().size = encodeChunk(editedChunks[i], generatedChunks[i],
+				                                batch.back().data);
+			}
+			storage.writeChunks(batch.data(), batch.size());
+		}
+		storage.checkpoint();
+		seconds = watch.getTimeSeconds();
+	}
+	std::printf("%22s %8zu %12.1f %14.0f %14zu\n", "batched, journaled", NUM_EDITS,
+	            seconds * 1000.0f, NUM_EDITS / seconds, countWriteMismatches());
+	removeWorldFiles();
+}
+
+} // namespace vox
@@ -54,7 +54,12 @@ bool operator== (const ConfigData& lhs, const ConfigData& rhs) noexcept
 	
 	// Voxel
 	lhs.verticalRange == rhs.verticalRange &&
-	lhs.horizontalRange == rhs.horizontalRange;
+	lhs.horizontalRange == rhs.horizontalRange &&
+	lhs.maxChunkUploadsPerFrame == rhs.maxChunkUploadsPerFrame &&
+	lhs.chunkStreamingBudgetMs == rhs.chunkStreamingBudgetMs &&
+	lhs.terrainType == rhs.terrainType &&
+	lhs.terrainSeed == rhs.terrainSeed &&
+	lhs.terrainCaves == rhs.terrainCaves;
 }
 
 bool operator!= (const ConfigData& lhs, const ConfigData& rhs) noexcept
@@ -120,8 +125,13 @@ void GlobalConfig::load() noexcept
 
 	// [Voxel]
 	static const string vStr = "Voxel";
-	verticalRange =   ip.sanitizeInt(vStr, "iVerticalRange", 1, 0, 128);
-	horizontalRange = ip.sanitizeInt(vStr, "iHorizontalRange", 2, 0, 128);
+	terrainCaves =            ip.sanitizeBool(vStr, "bTerrainCaves", false);
+	chunkStreamingBudgetMs =  ip.sanitizeFloat(vStr, "fChunkStreamingBudgetMs", 4.0f, 0.0f, 1000.0f);
+	horizontalRange =         ip.sanitizeInt(vStr, "iHorizontalRange", 2, 0, 128);
+	maxChunkUploadsPerFrame = ip.sanitizeInt(vStr, "iMaxChunkUploadsPerFrame", 16, 0, 65536);
+	terrainSeed =             ip.sanitizeInt(vStr, "iTerrainSeed", 0, 0, INT32_MAX);
+	terrainType =             ip.sanitizeInt(vStr, "iTerrainType", 0, 0, 1);
+	verticalRange =           ip.sanitizeInt(vStr, "iVerticalRange", 1, 0, 128);
 }
 
 void GlobalConfig::save() noexcept
@@ -149,8 +159,13 @@ void GlobalConfig::save() noexcept
 
 	// [Voxel]
 	static const string vStr = "Voxel";
-	mIniParser.setInt(vStr, "iVerticalRange", verticalRange);
+	mIniParser.setBool(vStr, "bTerrainCaves", terrainCaves);
+	mIniParser.setFloat(vStr, "fChunkStreamingBudgetMs", chunkStreamingBudgetMs);
 	mIniParser.setInt(vStr, "iHorizontalRange", horizontalRange);
+	mIniParser.setInt(vStr, "iMaxChunkUploadsPerFrame", maxChunkUploadsPerFrame);
+	mIniParser.setInt(vStr, "iTerrainSeed", terrainSeed);
+	mIniParser.setInt(vStr, "iTerrainType", terrainType);
+	mIniParser.setInt(vStr, "iVerticalRange", verticalRange);
 
 	if (!mIniParser.save()) {
 		std::cerr << "Couldn't save config.ini at: " << userIniPath() << std::endl;
@@ -184,6 +199,11 @@ void GlobalConfig::data(const ConfigData& configData) noexcept
 	// Voxel
 	this->verticalRange = configData.verticalRange;
 	this->horizontalRange = configData.horizontalRange;
+	this->maxChunkUploadsPerFrame = configData.maxChunkUploadsPerFrame;
+	this->chunkStreamingBudgetMs = configData.chunkStreamingBudgetMs;
+	this->terrainType = configData.terrainType;
+	this->terrainSeed = configData.terrainSeed;
+	this->terrainCaves = configData.terrainCaves;
 }
 
 // GlobalConfig: Private constructors & destructors
@@ -32,6 +32,11 @@ struct ConfigData {
 
 	// Voxel
 	int32_t verticalRange, horizontalRange;
+	int32_t maxChunkUploadsPerFrame; // 0 = unlimited
+	float chunkStreamingBudgetMs; // 0 = unlimited
+	int32_t terrainType; // 0 = paraboloid, 1 = noise, see TerrainType
+	int32_t terrainSeed;
+	bool terrainCaves; // Only used by noise terrain
 };
 
 bool operator== (const ConfigData& lhs, const ConfigData& rhs) noexcept;
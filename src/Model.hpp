@@ -3,8 +3,15 @@
 #define VOX_MODEL_HPP
 
 #include "model/Chunk.hpp"
+#include "model/ChunkLoader.hpp"
 #include "model/ChunkMesh.hpp"
+#include "model/ChunkMeshBuilder.hpp"
+#include "model/ChunkRing.hpp"
+#include "model/ChunkWriter.hpp"
+#include "model/Noise.hpp"
+#include "model/PackedChunk.hpp"
 #include "model/TerrainGeneration.hpp"
+#include "model/TerrainGenerator.hpp"
 #include "model/Voxel.hpp"
 #include "model/World.hpp"
 
@@ -1,74 +1,584 @@
 #include "io/ChunkIO.hpp"
 
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <algorithm> // std::find, std::min
+#include <cstring> // std::memcpy, std::memset
+
+#include <sfz/Assert.hpp>
 #include <sfz/util/IO.hpp>
 
 namespace vox {
 
+using std::uint8_t;
+using std::uint16_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
 namespace {
 
+const size_t VOXELS_PER_CHUNK = CHUNK_NUM_VOXELS;
+const size_t DELTA_HEADER_SIZE = 3; // Codec tag and uint16 count
+const size_t DELTA_ENTRY_SIZE = 3;
+const size_t RUN_SIZE = 2; // uint8 length - 1 and uint8 voxel type
+const size_t MAX_RUN_LENGTH = 256;
+const uint32_t JOURNAL_MAGIC = 0x464A564D; // "MVJF" in little endian
+const size_t JOURNAL_FRAME_HEADER_SIZE = 8; // Magic and chunk count
+const size_t JOURNAL_CHUNK_HEADER_SIZE = 14; // Offset and size
+const size_t JOURNAL_CHECKPOINT_SIZE = 1 << 20; // Journal size that triggers a checkpoint
+const size_t TERRAIN_SETTINGS_SIZE = 6;
+
 std::string directoryPath(const std::string& worldName)
 {
 	std::string directoryPath = basePath() + worldName + "/";
 	return std::move(directoryPath);
 }
 
-std::string filename(int xOffset, int yOffset, int zOffset, const std::string& worldName)
+std::string terrainFilename(const std::string& worldName)
+{
+	return directoryPath(worldName) + "terrain.bin";
+}
+
+bool ensureDirectoryExists(const std::string& worldName, const std::string& filePath)
+{
+	std::string dirPath = directoryPath(worldName);
+	if (sfz::directoryExists(dirPath.c_str())) return true;
+
+	// Another thread might have created the directory in between the two calls
+	if(!sfz::createDirectory(dirPath.c_str()) && !sfz::directoryExists(dirPath.c_str())) {
+		std::cerr << "Couldn't create directory: \"" << dirPath << "\", can't write file: \""
+		          << filePath << "\"" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool writeFile(const std::string& filePath, const uint8_t* data, size_t size)
+{
+	std::FILE* file = fopen(filePath.c_str(), "wb");
+	if (file == NULL) return false;
+
+	size_t writeCount = fwrite(data, 1, size, file);
+	fclose(file);
+
+	if (writeCount != size) {
+		std::cerr << "Could only write " << writeCount << " of " << size << " bytes to file: "
+		          << filePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string journalFilename(const std::string& worldName)
+{
+	return directoryPath(worldName) + "journal.bin";
+}
+
+std::string regionFilename(const vec3i& regionOffset, const std::string& worldName)
+{
+	return directoryPath(worldName) + "region__" + std::to_string(regionOffset[0]) + "x_"
+	     + std::to_string(regionOffset[1]) + "y_" + std::to_string(regionOffset[2]) + "z.bin";
+}
+
+// Arithmetic shift, negative chunk offsets round towards negative infinity
+inline vec3i regionOffset(const vec3i& chunkOffset) noexcept
+{
+	return vec3i{chunkOffset[0] >> 4, chunkOffset[1] >> 4, chunkOffset[2] >> 4};
+}
+
+static_assert(REGION_SIZE == 16, "regionOffset() assumes 16 chunks per region axis");
+
+inline uint64_t regionKey(const vec3i& regionOffset) noexcept
+{
+	const uint64_t MASK = (uint64_t(1) << 21) - 1;
+	return ((uint64_t(regionOffset[0]) & MASK) << 42) | ((uint64_t(regionOffset[1]) & MASK) << 21) |
+	       (uint64_t(regionOffset[2]) & MASK);
+}
+
+inline size_t regionChunkIndex(const vec3i& chunkOffset) noexcept
+{
+	return RegionFile::chunkIndex(chunkOffset[0], chunkOffset[1], chunkOffset[2]);
+}
+
+inline void appendU32(vector<uint8_t>& bytes, uint32_t value) noexcept
+{
+	for (size_t i = 0; i < 4; i++) bytes.push_back(uint8_t(value >> (i * 8)));
+}
+
+inline uint32_t loadU32(const uint8_t* ptr) noexcept
 {
-	std::string filePath = directoryPath(worldName) + "chunk__" + std::to_string(xOffset) + "x_"
-	                     + std::to_string(yOffset) + "y_" + std::to_string(zOffset) + "z.bin";
-	return std::move(filePath);
+	return uint32_t(ptr[0]) | (uint32_t(ptr[1]) << 8) | (uint32_t(ptr[2]) << 16) |
+	       (uint32_t(ptr[3]) << 24);
+}
+
+uint32_t fnv1a(const uint8_t* data, size_t size) noexcept
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+	return hash;
+}
+
+// Parses the journal frame at the start of data, returns its size or 0 if it is incomplete or
+// corrupt
+size_t parseJournalFrame(const uint8_t* data, size_t size, vector<EncodedChunk>& chunks) noexcept
+{
+	if (size < JOURNAL_FRAME_HEADER_SIZE || loadU32(data) != JOURNAL_MAGIC) return 0;
+	const size_t numChunks = loadU32(data + 4);
+	const size_t firstChunk = chunks.size();
+	size_t pos = JOURNAL_FRAME_HEADER_SIZE;
+	for (size_t i = 0; i < numChunks; i++) {
+		if (size - pos < JOURNAL_CHUNK_HEADER_SIZE) break;
+		const size_t chunkSize = size_t(data[pos + 12] | (data[pos + 13] << 8));
+		if (chunkSize > CHUNK_MAX_ENCODED_SIZE ||
+		    size - pos - JOURNAL_CHUNK_HEADER_SIZE < chunkSize) break;
+		chunks.emplace_back();
+		EncodedChunk& chunk = chunks.back();
+		for (size_t j = 0; j < 3; j++) chunk.offset[j] = int32_t(loadU32(data + pos + j * 4));
+		chunk.size = chunkSize;
+		std::memcpy(chunk.data, data + pos + JOURNAL_CHUNK_HEADER_SIZE, chunkSize);
+		pos += JOURNAL_CHUNK_HEADER_SIZE + chunkSize;
+	}
+	if (chunks.size() - firstChunk != numChunks || size - pos < 4 ||
+	    loadU32(data + pos) != fnv1a(data + 4, pos - 4)) {
+		chunks.resize(firstChunk);
+		return 0;
+	}
+	return pos + 4;
+}
+
+// Writes the codec tag and runs to out, returns the size or 0 if it wouldn't be below maxSize
+size_t encodeRuns(const uint8_t* voxels, uint8_t* out, size_t maxSize) noexcept
+{
+	out[0] = uint8_t(ChunkCodec::RLE);
+	size_t size = 1;
+	for (size_t i = 0; i < VOXELS_PER_CHUNK;) {
+		const uint8_t type = voxels[i];
+		size_t end = i + 1;
+		while (end < VOXELS_PER_CHUNK && end - i < MAX_RUN_LENGTH && voxels[end] == type) end++;
+		if (size + RUN_SIZE >= maxSize) return 0;
+		out[size] = uint8_t(end - i - 1);
+		out[size + 1] = type;
+		size += RUN_SIZE;
+		i = end;
+	}
+	return size;
+}
+
+bool decodeRuns(uint8_t* voxels, const uint8_t* data, size_t size) noexcept
+{
+	if ((size - 1) % RUN_SIZE != 0) return false;
+	size_t i = 0;
+	for (const uint8_t* run = data + 1; run < data + size; run += RUN_SIZE) {
+		const size_t length = size_t(run[0]) + 1;
+		if (i + length > VOXELS_PER_CHUNK) return false;
+		std::memset(voxels + i, run[1], length);
+		i += length;
+	}
+	return i == VOXELS_PER_CHUNK;
+}
+
+// Encodes the raw voxels of a chunk file, returns the size written to out, 0 if data is invalid
+size_t convertChunkFileData(const uint8_t* data, size_t size, uint8_t* out) noexcept
+{
+	if (size != VOXELS_PER_CHUNK) return 0;
+	size_t runsSize = encodeRuns(data, out, VOXELS_PER_CHUNK);
+	if (runsSize != 0) return runsSize;
+	std::memcpy(out, data, VOXELS_PER_CHUNK);
+	return VOXELS_PER_CHUNK;
 }
 
 } // anonymous namespace
 
-bool readChunk(Chunk& chunk, int xOffset, int yOffset, int zOffset, const std::string& worldName)
+// Chunk encoding
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+size_t encodeChunk(const Chunk& chunk, const Chunk& generated, uint8_t* out) noexcept
 {
-	static const size_t VOXELS_PER_CHUNK = CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE;
-	std::string filePath = filename(xOffset, yOffset, zOffset, worldName);
-	if (!sfz::directoryExists(filePath.c_str())) return false;
+	static_assert(sizeof(Voxel) == 1, "Voxel is padded.");
+	size_t count = 0;
+	for (size_t i = 0; i < VOXELS_PER_CHUNK; i++) {
+		if (chunk.mVoxels[i].mType != generated.mVoxels[i].mType) count++;
+	}
+	if (count == 0) return 0;
 
-	std::FILE* chunkFile = fopen(filePath.c_str(), "rb");
+	// Runs are only written if they are smaller than both the delta and the raw voxels
+	const uint8_t* voxels = &chunk.mVoxels[0].mType;
+	const size_t deltaSize = DELTA_HEADER_SIZE + count * DELTA_ENTRY_SIZE;
+	size_t runsSize = encodeRuns(voxels, out, std::min(deltaSize, VOXELS_PER_CHUNK));
+	if (runsSize != 0) return runsSize;
 
-	size_t readCount = fread(chunk.mChunkPart8s, sizeof(Voxel), VOXELS_PER_CHUNK, chunkFile);
-	fclose(chunkFile);
+	if (deltaSize >= VOXELS_PER_CHUNK) {
+		std::memcpy(out, voxels, VOXELS_PER_CHUNK);
+		return VOXELS_PER_CHUNK;
+	}
 
-	if (readCount != VOXELS_PER_CHUNK) {
-		std::cerr << "Could only read " << readCount << " of " << VOXELS_PER_CHUNK
-		          << " voxels from file: " << filePath << std::endl;
-		return false;
+	out[0] = uint8_t(ChunkCodec::DELTA);
+	out[1] = uint8_t(count);
+	out[2] = uint8_t(count >> 8);
+	uint8_t* entry = out + DELTA_HEADER_SIZE;
+	for (size_t i = 0; i < VOXELS_PER_CHUNK; i++) {
+		if (chunk.mVoxels[i].mType == generated.mVoxels[i].mType) continue;
+		entry[0] = uint8_t(i);
+		entry[1] = uint8_t(i >> 8);
+		entry[2] = chunk.mVoxels[i].mType;
+		entry += DELTA_ENTRY_SIZE;
+	}
+	return deltaSize;
+}
+
+bool decodeChunk(Chunk& chunk, const uint8_t* data, size_t size, const vec3i& offset,
+                 const TerrainGenerator& generator, bool reportInvalid) noexcept
+{
+	uint8_t* voxels = &chunk.mVoxels[0].mType;
+	bool valid = false;
+	if (size == VOXELS_PER_CHUNK) {
+		std::memcpy(voxels, data, VOXELS_PER_CHUNK);
+		valid = true;
+	}
+	else if (size >= 1 && data[0] == uint8_t(ChunkCodec::RLE)) {
+		valid = decodeRuns(voxels, data, size);
+	}
+	else if (size >= DELTA_HEADER_SIZE && data[0] == uint8_t(ChunkCodec::DELTA)) {
+		const size_t count = size_t(data[1] | (data[2] << 8));
+		valid = size == DELTA_HEADER_SIZE + count * DELTA_ENTRY_SIZE;
+		if (valid) chunk = generator.generateChunk(offset);
+		const uint8_t* entry = data + DELTA_HEADER_SIZE;
+		for (size_t i = 0; valid && i < count; i++, entry += DELTA_ENTRY_SIZE) {
+			const size_t index = size_t(entry[0] | (entry[1] << 8));
+			valid = index < VOXELS_PER_CHUNK;
+			if (valid) chunk.mVoxels[index] = Voxel{entry[2]};
+		}
 	}
 
+	if (!valid) {
+		if (!reportInvalid) return false;
+		std::cerr << "Invalid data of " << size << " bytes for chunk (" << offset[0] << ", "
+		          << offset[1] << ", " << offset[2] << ")" << std::endl;
+		return false;
+	}
+	chunk.updateOccupancy();
 	return true;
 }
 
-bool writeChunk(Chunk& chunk, int xOffset, int yOffset, int zOffset, const std::string& worldName)
+// ChunkStorage: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+ChunkStorage::ChunkStorage(const std::string& worldName) noexcept
+:
+	mWorldName(worldName)
 {
-	static const size_t VOXELS_PER_CHUNK = CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE;
-	std::string dirPath = directoryPath(worldName);
-	std::string filePath = filename(xOffset, yOffset, zOffset, worldName);
-
-	// Make sure directory exists
-	if (!sfz::directoryExists(dirPath.c_str())) {
-		if(!sfz::createDirectory(dirPath.c_str())) {
-			std::cerr << "Couldn't create directory: \"" << dirPath << "\", can't write chunk: \""
-			          << filePath << "\"" << std::endl;
-			return false;
+	// Only the headers are read, region files are opened once a stored chunk in them is needed
+	const std::string dirPath = directoryPath(mWorldName);
+	for (const std::string& name : listFiles(dirPath)) {
+		vec3i offset;
+		int numParsed = 0;
+		if (std::sscanf(name.c_str(), "region__%dx_%dy_%dz.bin%n", &offset[0], &offset[1],
+		                &offset[2], &numParsed) != 3 || size_t(numParsed) != name.size()) continue;
+		std::bitset<REGION_NUM_CHUNKS> stored;
+		if (RegionFile::readStoredChunks(dirPath + name, stored) && stored.any()) {
+			mManifest[regionKey(offset)] = stored;
 		}
 	}
+}
 
-	std::FILE* chunkFile = fopen(filePath.c_str(), "wb");
-	if (chunkFile == NULL) return false;
+ChunkStorage::~ChunkStorage() noexcept
+{
+	checkpoint();
+	if (mJournal != nullptr) std::fclose(mJournal);
+}
 
-	size_t writeCount = fwrite(chunk.mChunkPart8s, sizeof(Voxel), VOXELS_PER_CHUNK, chunkFile);
-	fclose(chunkFile);
+// ChunkStorage: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-	if (writeCount != VOXELS_PER_CHUNK) {
-		std::cerr << "Could only write " << writeCount << " of " << VOXELS_PER_CHUNK
-		          << " voxels to file: " << filePath << std::endl;
+bool ChunkStorage::readChunk(Chunk& chunk, const vec3i& offset,
+                             const TerrainGenerator& generator) noexcept
+{
+	// Chunks that were never stored are generated without touching the file system
+	if (!isStored(offset)) return false;
+	RegionFile* file = region(offset, false);
+	if (file == nullptr) return false;
+
+	// Decoded straight from the mapping when possible, decodeChunk() validates everything it reads.
+	// A write during decoding can give wrong voxels that look valid or data that doesn't, then the
+	// chunk is read again under the region's lock. Only that read reports invalid data.
+	size_t size = 0;
+	uint64_t numWrites = 0;
+	const uint8_t* data = file->mappedData(regionChunkIndex(offset), size, numWrites);
+	if (data != nullptr && decodeChunk(chunk, data, size, offset, generator, false) &&
+	    file->numWrites() == numWrites) {
+		return true;
+	}
+
+	uint8_t buffer[REGION_MAX_CHUNK_SIZE];
+	size = file->read(regionChunkIndex(offset), buffer);
+	if (size == 0) return false;
+	return decodeChunk(chunk, buffer, size, offset, generator);
+}
+
+bool ChunkStorage::writeChunk(const Chunk& chunk, const Chunk& generated,
+                              const vec3i& offset) noexcept
+{
+	EncodedChunk encoded;
+	encoded.offset = offset;
+	encoded.size = encodeChunk(chunk, generated, encoded.data);
+	return writeChunks(&encoded, 1);
+}
+
+bool ChunkStorage::writeChunks(const EncodedChunk* chunks, size_t numChunks) noexcept
+{
+	if (numChunks == 0) return true;
+	std::lock_guard<std::mutex> lock{mJournalMutex};
+
+	mFrame.clear();
+	appendU32(mFrame, JOURNAL_MAGIC);
+	appendU32(mFrame, uint32_t(numChunks));
+	for (size_t i = 0; i < numChunks; i++) {
+		const EncodedChunk& chunk = chunks[i];
+		sfz_assert_debug(chunk.size <= CHUNK_MAX_ENCODED_SIZE);
+		for (size_t j = 0; j < 3; j++) appendU32(mFrame, uint32_t(chunk.offset[j]));
+		mFrame.push_back(uint8_t(chunk.size));
+		mFrame.push_back(uint8_t(chunk.size >> 8));
+		mFrame.insert(mFrame.end(), chunk.data, chunk.data + chunk.size);
+	}
+	appendU32(mFrame, fnv1a(mFrame.data() + 4, mFrame.size() - 4));
+
+	const std::string filePath = journalFilename(mWorldName);
+	if (mJournal == nullptr) {
+		if (!ensureDirectoryExists(mWorldName, filePath)) return false;
+		mJournal = std::fopen(filePath.c_str(), "ab");
+	}
+	if (mJournal == nullptr ||
+	    std::fwrite(mFrame.data(), 1, mFrame.size(), mJournal) != mFrame.size() ||
+	    !syncFile(mJournal)) {
+		std::cerr << "Couldn't append to journal: " << filePath << std::endl;
 		return false;
 	}
-	
+	mJournalSize += mFrame.size();
+
+	// Pristine chunks are regenerated on load, stored data would override them, so they are removed
+	bool success = true;
+	for (size_t i = 0; i < numChunks; i++) {
+		if (!writeToRegion(chunks[i])) success = false;
+	}
+	if (mJournalSize >= JOURNAL_CHECKPOINT_SIZE) checkpointJournal();
+	return success;
+}
+
+bool ChunkStorage::checkpoint() noexcept
+{
+	std::lock_guard<std::mutex> lock{mJournalMutex};
+	return checkpointJournal();
+}
+
+size_t ChunkStorage::recoverJournal() noexcept
+{
+	std::lock_guard<std::mutex> lock{mJournalMutex};
+	const std::string filePath = journalFilename(mWorldName);
+	if (!sfz::fileExists(filePath.c_str())) return 0;
+	const vector<uint8_t> journal = sfz::readBinaryFile(filePath.c_str());
+	if (journal.empty()) return 0;
+
+	// Frames that were being appended during a crash are skipped, a frame only counts if its
+	// checksum matches
+	vector<EncodedChunk> chunks;
+	size_t numSkippedBytes = 0;
+	for (size_t pos = 0; pos < journal.size();) {
+		size_t frameSize = parseJournalFrame(journal.data() + pos, journal.size() - pos, chunks);
+		if (frameSize == 0) {
+			numSkippedBytes++;
+			pos++;
+		}
+		pos += frameSize;
+	}
+
+	for (const EncodedChunk& chunk : chunks) writeToRegion(chunk);
+	mJournalSize = journal.size();
+	checkpointJournal();
+
+	std::cout << "Recovered " << chunks.size() << " chunks from the journal of world \""
+	          << mWorldName << "\"";
+	if (numSkippedBytes != 0) std::cout << ", skipped " << numSkippedBytes << " invalid bytes";
+	std::cout << "." << std::endl;
+	return chunks.size();
+}
+
+size_t ChunkStorage::convertChunkFiles() noexcept
+{
+	const std::string dirPath = directoryPath(mWorldName);
+	vector<EncodedChunk> converted;
+	vector<std::string> convertedPaths;
+	for (const std::string& name : listFiles(dirPath)) {
+		vec3i offset;
+		int numParsed = 0;
+		if (std::sscanf(name.c_str(), "chunk__%dx_%dy_%dz.bin%n", &offset[0], &offset[1], &offset[2],
+		                &numParsed) != 3 || size_t(numParsed) != name.size()) continue;
+
+		const std::string filePath = dirPath + name;
+		std::FILE* chunkFile = fopen(filePath.c_str(), "rb");
+		if (chunkFile == NULL) continue;
+
+		// Chunk files hold all voxels, read one byte more to detect longer files
+		uint8_t buffer[VOXELS_PER_CHUNK + 1];
+		size_t size = fread(buffer, 1, sizeof(buffer), chunkFile);
+		fclose(chunkFile);
+
+		converted.emplace_back();
+		converted.back().offset = offset;
+		converted.back().size = convertChunkFileData(buffer, size, converted.back().data);
+		if (converted.back().size == 0) {
+			std::cerr << "Invalid chunk file of " << size << " bytes: " << filePath << std::endl;
+			converted.pop_back();
+			continue;
+		}
+		convertedPaths.push_back(filePath);
+	}
+	if (converted.empty()) return 0;
+
+	// The chunk files are only removed once the region files have reached the disk
+	if (!writeChunks(converted.data(), converted.size()) || !checkpoint()) {
+		std::cerr << "Couldn't convert chunk files of world \"" << mWorldName << "\"" << std::endl;
+		return 0;
+	}
+	for (const std::string& filePath : convertedPaths) {
+		if (std::remove(filePath.c_str()) != 0) {
+			std::cerr << "Couldn't remove converted chunk file: " << filePath << std::endl;
+		}
+	}
+	std::cout << "Converted " << converted.size() << " chunk files of world \"" << mWorldName
+	          << "\" to region files." << std::endl;
+	return converted.size();
+}
+
+// ChunkStorage: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+RegionFile* ChunkStorage::region(const vec3i& chunkOffset, bool create) noexcept
+{
+	const vec3i offset = regionOffset(chunkOffset);
+	std::lock_guard<std::mutex> lock{mMutex};
+
+	unique_ptr<RegionFile>& file = mRegions[regionKey(offset)];
+	if (file == nullptr) {
+		file.reset(new (std::nothrow) RegionFile{});
+		if (file == nullptr) return nullptr;
+	} else if (file->isOpen()) {
+		return file.get();
+	} else if (!create) {
+		return nullptr;
+	}
+
+	std::string filePath = regionFilename(offset, mWorldName);
+	if (create && !ensureDirectoryExists(mWorldName, filePath)) return nullptr;
+	if (!file->open(filePath, create)) return nullptr;
+	return file.get();
+}
+
+bool ChunkStorage::isStored(const vec3i& chunkOffset) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	auto itr = mManifest.find(regionKey(regionOffset(chunkOffset)));
+	return itr != mManifest.end() && itr->second[regionChunkIndex(chunkOffset)];
+}
+
+void ChunkStorage::markStored(const vec3i& chunkOffset, bool stored) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	const uint64_t key = regionKey(regionOffset(chunkOffset));
+	if (!stored && mManifest.find(key) == mManifest.end()) return;
+	mManifest[key][regionChunkIndex(chunkOffset)] = stored;
+}
+
+bool ChunkStorage::writeToRegion(const EncodedChunk& chunk) noexcept
+{
+	const size_t index = regionChunkIndex(chunk.offset);
+	RegionFile* file = region(chunk.offset, chunk.size != 0);
+	bool success;
+	if (chunk.size == 0) success = file == nullptr || file->erase(index);
+	else success = file != nullptr && file->write(index, chunk.data, chunk.size);
+
+	if (success) markStored(chunk.offset, chunk.size != 0);
+	if (success && file != nullptr &&
+	    std::find(mDirtyRegions.begin(), mDirtyRegions.end(), file) == mDirtyRegions.end()) {
+		mDirtyRegions.push_back(file);
+	}
+
+	// The journal is the only copy of a failed chunk until a later write of it succeeds
+	auto failed = std::find(mFailedChunks.begin(), mFailedChunks.end(), chunk.offset);
+	if (success && failed != mFailedChunks.end()) mFailedChunks.erase(failed);
+	else if (!success && failed == mFailedChunks.end()) mFailedChunks.push_back(chunk.offset);
+	return success;
+}
+
+bool ChunkStorage::checkpointJournal() noexcept
+{
+	if (mJournalSize == 0 && mDirtyRegions.empty()) return true;
+	if (!mFailedChunks.empty()) return false;
+	for (RegionFile* file : mDirtyRegions) {
+		if (!file->sync()) return false;
+	}
+	mDirtyRegions.clear();
+
+	// Truncated and synced, so a crash can't bring back frames that are older than the regions
+	if (mJournal != nullptr) std::fclose(mJournal);
+	const std::string filePath = journalFilename(mWorldName);
+	mJournal = std::fopen(filePath.c_str(), "wb");
+	if (mJournal == nullptr || !syncFile(mJournal)) {
+		std::cerr << "Couldn't empty journal: " << filePath << std::endl;
+		return false;
+	}
+	mJournalSize = 0;
+	return true;
+}
+
+// Terrain settings
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+bool readTerrainSettings(TerrainSettings& settings, const std::string& worldName)
+{
+	std::string filePath = terrainFilename(worldName);
+	if (!sfz::directoryExists(filePath.c_str())) return false;
+
+	std::FILE* file = fopen(filePath.c_str(), "rb");
+	if (file == NULL) return false;
+	uint8_t buffer[TERRAIN_SETTINGS_SIZE];
+	size_t readCount = fread(buffer, 1, TERRAIN_SETTINGS_SIZE, file);
+	fclose(file);
+
+	if (readCount != TERRAIN_SETTINGS_SIZE) {
+		std::cerr << "Invalid terrain settings file: " << filePath << std::endl;
+		return false;
+	}
+	settings.type = static_cast<TerrainType>(buffer[0]);
+	settings.caves = buffer[1] != 0;
+	settings.seed = uint32_t(buffer[2]) | (uint32_t(buffer[3]) << 8) | (uint32_t(buffer[4]) << 16) |
+	                (uint32_t(buffer[5]) << 24);
 	return true;
 }
 
-} // namespace vox
\ No newline at end of file
+bool writeTerrainSettings(const TerrainSettings& settings, const std::string& worldName)
+{
+	std::string filePath = terrainFilename(worldName);
+	if (!ensureDirectoryExists(worldName, filePath)) return false;
+
+	const uint8_t buffer[TERRAIN_SETTINGS_SIZE] = {
+		uint8_t(settings.type), uint8_t(settings.caves ? 1 : 0),
+		uint8_t(settings.seed), uint8_t(settings.seed >> 8), uint8_t(settings.seed >> 16),
+		uint8_t(settings.seed >> 24)
+	};
+	return writeFile(filePath, buffer, TERRAIN_SETTINGS_SIZE);
+}
+
+bool hasStoredChunks(const std::string& worldName)
+{
+	const std::string dirPath = directoryPath(worldName);
+	for (const std::string& name : listFiles(dirPath)) {
+		if (name.compare(0, 7, "chunk__") == 0 || name.compare(0, 8, "region__") == 0) return true;
+		const std::string filePath = dirPath + name;
+		if (filePath == journalFilename(worldName) && sfz::sizeofFile(filePath.c_str()) > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace vox
@@ -2,20 +2,170 @@
 #ifndef VOX_IO_CHUNK_IO_HPP
 #define VOX_IO_CHUNK_IO_HPP
 
+#include <bitset>
+#include <cstdint> // uint8_t, uint64_t
 #include <string>
 #include <iostream>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
-#include "Model.hpp"
+#include <sfz/Math.hpp>
+
+#include "model/Chunk.hpp"
+#include "model/TerrainGenerator.hpp"
 #include "io/IOUtils.hpp"
+#include "io/RegionFile.hpp"
 
 namespace vox {
 
 using std::size_t;
+using std::uint8_t;
+using std::unique_ptr;
+using sfz::vec3i;
+
+/**
+ * Only chunks that differ from the generator's output are stored. A stored chunk is either all
+ * CHUNK_NUM_VOXELS voxels in ChunkIndex order, or (when smaller) a ChunkCodec tag followed by:
+ *  DELTA: a delta against the generated chunk, a little endian uint16 count followed by count
+ *         entries of uint16 ChunkIndex and uint8 voxel type.
+ *  RLE: runs of voxels in ChunkIndex order, uint8 length - 1 and uint8 voxel type per run.
+ * The encoder picks the smallest of the three, the size tells raw voxels apart.
+ *
+ * Chunks are packed into region files of REGION_SIZE^3 chunks each (see RegionFile). Worlds saved
+ * with one file of raw voxels per chunk are converted with ChunkStorage::convertChunkFiles().
+ *
+ * Writes are batched and appended to a journal before the region files are touched. A journal
+ * frame is a little endian uint32 magic and chunk count, per chunk int32 x, y, z offsets, uint16
+ * size (0 to remove the chunk) and the encoded data, then an FNV-1a checksum of everything after
+ * the magic. Each frame is synced to disk. Checkpoints sync the region files and empty the journal,
+ * recovery replays the complete frames of a journal left behind by a crash.
+ */
+
+enum class ChunkCodec : uint8_t {
+	DELTA = 1,
+	RLE = 2
+};
+
+const size_t CHUNK_MAX_ENCODED_SIZE = CHUNK_NUM_VOXELS;
+
+/** @brief A chunk encoded with encodeChunk(), size 0 means the chunk is removed from storage. */
+struct EncodedChunk final {
+	vec3i offset;
+	size_t size;
+	uint8_t data[CHUNK_MAX_ENCODED_SIZE];
+};
+
+/**
+ * @brief Encodes the chunk against generated (the generator's output for the chunk).
+ * @param out at least CHUNK_MAX_ENCODED_SIZE bytes
+ * @return the size of the encoded data, 0 if chunk is equal to generated and shouldn't be stored
+ */
+size_t encodeChunk(const Chunk& chunk, const Chunk& generated, uint8_t* out) noexcept;
+
+/**
+ * @brief Decodes data written by encodeChunk(), returns false if it is invalid.
+ * @param generator the generator of the world, used as the base of deltas
+ * @param reportInvalid whether invalid data is reported on stderr
+ */
+bool decodeChunk(Chunk& chunk, const uint8_t* data, size_t size, const vec3i& offset,
+                 const TerrainGenerator& generator, bool reportInvalid = true) noexcept;
+
+/**
+ * @brief The stored chunks of a world. All methods are thread safe, region files are opened on
+ * first use and kept open. Which chunks are stored is known from construction on, so loads of
+ * chunks that were never stored don't touch the file system.
+ */
+class ChunkStorage final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkStorage() = delete;
+	ChunkStorage(const ChunkStorage&) = delete;
+	ChunkStorage& operator= (const ChunkStorage&) = delete;
+
+	explicit ChunkStorage(const std::string& worldName) noexcept;
+
+	/** @brief Checkpoints the journal. */
+	~ChunkStorage() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/**
+	 * @brief Reads the chunk, returns false if it isn't stored (or couldn't be read).
+	 * @param generator the generator of the world, used as the base of deltas
+	 */
+	bool readChunk(Chunk& chunk, const vec3i& offset, const TerrainGenerator& generator) noexcept;
+
+	/**
+	 * @brief Stores the chunk encoded with encodeChunk(). A chunk equal to generated (the
+	 * generator's output for the chunk) is removed from storage. A batch of one, see writeChunks().
+	 */
+	bool writeChunk(const Chunk& chunk, const Chunk& generated, const vec3i& offset) noexcept;
+
+	/**
+	 * @brief Appends the chunks to the journal as one frame and syncs it, then writes them to the
+	 * region files. The chunks are durable once the journal is synced, even if this returns false.
+	 */
+	bool writeChunks(const EncodedChunk* chunks, size_t numChunks) noexcept;
+
+	/** @brief Syncs the region files written since the last checkpoint and empties the journal. */
+	bool checkpoint() noexcept;
+
+	/**
+	 * @brief Writes the chunks of the journal left by a crash to the region files, then
+	 * checkpoints. Must be called before anything else is written.
+	 * @return the number of chunks recovered
+	 */
+	size_t recoverJournal() noexcept;
+
+	/**
+	 * @brief Moves the chunk files of the old one file per chunk layout into region files.
+	 * @return the number of chunk files converted
+	 */
+	size_t convertChunkFiles() noexcept;
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/** @brief Returns the region file containing the chunk, nullptr if it doesn't exist. */
+	RegionFile* region(const vec3i& chunkOffset, bool create) noexcept;
+
+	bool isStored(const vec3i& chunkOffset) noexcept;
+	void markStored(const vec3i& chunkOffset, bool stored) noexcept;
+	bool writeToRegion(const EncodedChunk& chunk) noexcept;
+	bool checkpointJournal() noexcept; // Requires mJournalMutex
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	const std::string mWorldName;
+	std::mutex mMutex;
+	// Also holds regions that couldn't be opened, so missing files are only looked for once
+	std::unordered_map<std::uint64_t, unique_ptr<RegionFile>> mRegions;
+	// The chunks stored in each region file, read from their headers on construction
+	std::unordered_map<std::uint64_t, std::bitset<REGION_NUM_CHUNKS>> mManifest;
+
+	std::mutex mJournalMutex; // Held for a whole batch, so batches reach the regions in order
+	std::FILE* mJournal = nullptr;
+	size_t mJournalSize = 0;
+	std::vector<uint8_t> mFrame;
+	std::vector<RegionFile*> mDirtyRegions; // Written since the last checkpoint
+	std::vector<vec3i> mFailedChunks; // Only in the journal, which can't be emptied yet
+};
+
+/** @brief Reads the terrain settings the world was created with, false if there are none. */
+bool readTerrainSettings(TerrainSettings& settings, const std::string& worldName);
+bool writeTerrainSettings(const TerrainSettings& settings, const std::string& worldName);
 
-bool readChunk(Chunk& chunk, int xOffset, int yOffset, int zOffset, const std::string& worldName);
-bool writeChunk(Chunk& chunk, int xOffset, int yOffset, int zOffset, const std::string& worldName);
+/** @brief Returns whether the world has stored chunks (chunk files, region files or a journal). */
+bool hasStoredChunks(const std::string& worldName);
 
 } // namespace vox
 
-#endif
\ No newline at end of file
+#endif
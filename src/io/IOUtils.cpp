@@ -2,6 +2,14 @@
 
 #include "sfz/SDL.hpp"
 
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
 namespace vox {
 
 const std::string& basePath()
@@ -16,4 +24,39 @@ const std::string& assetsPath()
 	return ASSETS_PATH;
 }
 
+std::vector<std::string> listFiles(const std::string& dirPath)
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE handle = FindFirstFileA((dirPath + "*").c_str(), &findData);
+	if (handle == INVALID_HANDLE_VALUE) return names;
+	do {
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+			names.emplace_back(findData.cFileName);
+		}
+	} while (FindNextFileA(handle, &findData));
+	FindClose(handle);
+#else
+	DIR* dir = opendir(dirPath.c_str());
+	if (dir == nullptr) return names;
+	while (dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] == '.') continue;
+		names.emplace_back(entry->d_name);
+	}
+	closedir(dir);
+#endif
+	return names;
+}
+
+bool syncFile(std::FILE* file)
+{
+	if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
 } // namespace vox
\ No newline at end of file
@@ -2,13 +2,21 @@
 #ifndef VOX_IO_IO_UTILS_HPP
 #define VOX_IO_IO_UTILS_HPP
 
+#include <cstdio>
 #include <string>
+#include <vector>
 
 namespace vox {
 
 const std::string& basePath();
 const std::string& assetsPath();
 
+/** @brief Returns the names of the files in the directory (path ending with a separator). */
+std::vector<std::string> listFiles(const std::string& dirPath);
+
+/** @brief Flushes the file and waits until its data has reached the disk. */
+bool syncFile(std::FILE* file);
+
 } // namespace vox
 
 #endif
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "io/RegionFile.hpp"
+
+#include <iostream>
+
+#include <sfz/Assert.hpp>
+
+#include "io/IOUtils.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+const uint8_t MAGIC[4] = {'M', 'V', 'R', 'G'};
+const size_t VERSION_OFFSET = 4;
+const size_t TABLE_OFFSET = 16; // Magic, version and reserved bytes before the table
+const size_t HEADER_SIZE = TABLE_OFFSET + REGION_NUM_CHUNKS * 4;
+const size_t HEADER_SECTORS = (HEADER_SIZE + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+const uint32_t SIZE_BITS = 12;
+const uint32_t SIZE_MASK = (1u << SIZE_BITS) - 1;
+
+// Size of a file with every chunk at its largest and no free sectors
+const size_t MAX_UNFRAGMENTED_FILE_SIZE = HEADER_SECTORS * REGION_SECTOR_SIZE +
+                                          REGION_NUM_CHUNKS * REGION_MAX_CHUNK_SIZE;
+
+static_assert(REGION_MAX_CHUNK_SIZE - 1 <= SIZE_MASK, "Chunk size doesn't fit in a table entry");
+
+inline size_t firstSector(uint32_t entry) noexcept
+{
+	return entry >> SIZE_BITS;
+}
+
+inline size_t dataSize(uint32_t entry) noexcept
+{
+	return (entry & SIZE_MASK) + 1;
+}
+
+inline size_t sectorsFor(size_t size) noexcept
+{
+	return (size + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+}
+
+inline uint32_t loadU32(const uint8_t* ptr) noexcept
+{
+	return uint32_t(ptr[0]) | (uint32_t(ptr[1]) << 8) | (uint32_t(ptr[2]) << 16) |
+	       (uint32_t(ptr[3]) << 24);
+}
+
+inline void storeU32(uint8_t* ptr, uint32_t value) noexcept
+{
+	ptr[0] = uint8_t(value);
+	ptr[1] = uint8_t(value >> 8);
+	ptr[2] = uint8_t(value >> 16);
+	ptr[3] = uint8_t(value >> 24);
+}
+
+} // anonymous namespace
+
+// RegionFile: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+RegionFile::~RegionFile() noexcept
+{
+	unmapFile();
+	if (mFile != nullptr) std::fclose(mFile);
+}
+
+// RegionFile: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+bool RegionFile::open(const std::string& path, bool create) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	if (mFile != nullptr) return true;
+	mPath = path;
+
+	vector<uint8_t> header(HEADER_SECTORS * REGION_SECTOR_SIZE, 0);
+	mFile = std::fopen(path.c_str(), "r+b");
+	if (mFile == nullptr) {
+		if (!create) return false;
+		mFile = std::fopen(path.c_str(), "w+b");
+		if (mFile == nullptr) {
+			std::cerr << "Couldn't create region file: " << path << std::endl;
+			return false;
+		}
+
+		for (size_t i = 0; i < 4; i++) header[i] = MAGIC[i];
+		storeU32(&header[VERSION_OFFSET], REGION_VERSION);
+		if (std::fwrite(header.data(), 1, header.size(), mFile) != header.size() ||
+		    std::fflush(mFile) != 0) {
+			std::cerr << "Couldn't write header of region file: " << path << std::endl;
+			std::fclose(mFile);
+			mFile = nullptr;
+			std::remove(path.c_str());
+			return false;
+		}
+		for (size_t i = 0; i < REGION_NUM_CHUNKS; i++) mTable[i] = 0;
+		mUsedSectors.assign(HEADER_SECTORS, true);
+		mapFile();
+		return true;
+	}
+
+	bool valid = std::fread(header.data(), 1, HEADER_SIZE, mFile) == HEADER_SIZE;
+	for (size_t i = 0; i < 4; i++) valid = valid && header[i] == MAGIC[i];
+	valid = valid && loadU32(&header[VERSION_OFFSET]) == REGION_VERSION;
+	if (!valid || std::fseek(mFile, 0, SEEK_END) != 0) {
+		std::cerr << "Invalid region file: " << path << std::endl;
+		std::fclose(mFile);
+		mFile = nullptr;
+		return false;
+	}
+
+	// Entries pointing outside the file are dropped, the chunks are generated again
+	const size_t numSectors = sectorsFor((size_t)std::ftell(mFile));
+	mUsedSectors.assign(numSectors, false);
+	for (size_t i = 0; i < HEADER_SECTORS; i++) mUsedSectors[i] = true;
+	for (size_t i = 0; i < REGION_NUM_CHUNKS; i++) {
+		uint32_t entry = loadU32(&header[TABLE_OFFSET + i * 4]);
+		const size_t first = firstSector(entry);
+		if (entry != 0 && (first < HEADER_SECTORS || first + sectorsFor(dataSize(entry)) > numSectors)) {
+			std::cerr << "Invalid entry for chunk " << i << " in region file: " << path << std::endl;
+			entry = 0;
+		}
+		mTable[i] = entry;
+		if (entry != 0) markSectors(entry, true);
+	}
+	mapFile();
+	return true;
+}
+
+bool RegionFile::isOpen() const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	return mFile != nullptr;
+}
+
+const uint8_t* RegionFile::mappedData(size_t index, size_t& size,
+                                      uint64_t& numWrites) const noexcept
+{
+	sfz_assert_debug(index < REGION_NUM_CHUNKS);
+	std::lock_guard<std::mutex> lock{mMutex};
+	numWrites = mNumWrites;
+	const uint32_t entry = mTable[index];
+	if (mMapping == nullptr || entry == 0) return nullptr;
+
+	const size_t offset = firstSector(entry) * REGION_SECTOR_SIZE;
+	size = dataSize(entry);
+	if (offset + size > mMappingSize) return nullptr;
+	return mMapping + offset;
+}
+
+uint64_t RegionFile::numWrites() const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	return mNumWrites;
+}
+
+size_t RegionFile::read(size_t index, uint8_t* out) noexcept
+{
+	sfz_assert_debug(index < REGION_NUM_CHUNKS);
+	std::lock_guard<std::mutex> lock{mMutex};
+	if (mFile == nullptr || mTable[index] == 0) return 0;
+
+	const uint32_t entry = mTable[index];
+	const size_t size = dataSize(entry);
+	if (std::fseek(mFile, long(firstSector(entry) * REGION_SECTOR_SIZE), SEEK_SET) != 0 ||
+	    std::fread(out, 1, size, mFile) != size) {
+		std::cerr << "Couldn't read chunk " << index << " from region file: " << mPath << std::endl;
+		return 0;
+	}
+	return size;
+}
+
+bool RegionFile::write(size_t index, const uint8_t* data, size_t size) noexcept
+{
+	sfz_assert_debug(index < REGION_NUM_CHUNKS);
+	sfz_assert_debug(0 < size && size <= REGION_MAX_CHUNK_SIZE);
+	std::lock_guard<std::mutex> lock{mMutex};
+	if (mFile == nullptr) return false;
+	mNumWrites++; // Before anything changes, also if the write fails halfway
+
+	const uint32_t oldEntry = mTable[index];
+	const bool inPlace = oldEntry != 0 && sectorsFor(dataSize(oldEntry)) >= sectorsFor(size);
+	size_t first;
+	if (inPlace) {
+		first = firstSector(oldEntry);
+		markSectors(oldEntry, false);
+	} else {
+		first = findFreeSectors(sectorsFor(size));
+	}
+	sfz_assert_debug(first < (size_t(1) << (32 - SIZE_BITS)));
+	const uint32_t entry = uint32_t(first << SIZE_BITS) | uint32_t(size - 1);
+	markSectors(entry, true);
+
+	if (std::fseek(mFile, long(first * REGION_SECTOR_SIZE), SEEK_SET) != 0 ||
+	    std::fwrite(data, 1, size, mFile) != size || !writeEntry(index, entry)) {
+		std::cerr << "Couldn't write chunk " << index << " to region file: " << mPath << std::endl;
+		if (!inPlace) markSectors(entry, false);
+		return false;
+	}
+
+	// Moved chunks free their old sectors once the table points to the new ones
+	if (!inPlace && oldEntry != 0) markSectors(oldEntry, false);
+	return true;
+}
+
+bool RegionFile::erase(size_t index) noexcept
+{
+	sfz_assert_debug(index < REGION_NUM_CHUNKS);
+	std::lock_guard<std::mutex> lock{mMutex};
+	if (mFile == nullptr) return false;
+	mNumWrites++;
+
+	const uint32_t oldEntry = mTable[index];
+	if (oldEntry == 0) return true;
+	if (!writeEntry(index, 0)) {
+		std::cerr << "Couldn't erase chunk " << index << " in region file: " << mPath << std::endl;
+		return false;
+	}
+	markSectors(oldEntry, false);
+	return true;
+}
+
+bool RegionFile::sync() noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	if (mFile == nullptr) return false;
+	if (!syncFile(mFile)) {
+		std::cerr << "Couldn't sync region file: " << mPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+size_t RegionFile::chunkIndex(int x, int y, int z) noexcept
+{
+	const size_t MASK = REGION_SIZE - 1;
+	return (((size_t)x & MASK) * REGION_SIZE + ((size_t)y & MASK)) * REGION_SIZE + ((size_t)z & MASK);
+}
+
+bool RegionFile::readStoredChunks(const std::string& path,
+                                  std::bitset<REGION_NUM_CHUNKS>& stored) noexcept
+{
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (file == nullptr) return false;
+	vector<uint8_t> header(HEADER_SIZE);
+	bool valid = std::fread(header.data(), 1, HEADER_SIZE, file) == HEADER_SIZE;
+	std::fclose(file);
+
+	for (size_t i = 0; i < 4; i++) valid = valid && header[i] == MAGIC[i];
+	if (!valid || loadU32(&header[VERSION_OFFSET]) != REGION_VERSION) return false;
+	for (size_t i = 0; i < REGION_NUM_CHUNKS; i++) {
+		stored[i] = loadU32(&header[TABLE_OFFSET + i * 4]) != 0;
+	}
+	return true;
+}
+
+// RegionFile: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+// The mapping covers the largest unfragmented file on POSIX, pages are backed by the file as it
+// grows. Windows can't map beyond the end of a file without extending it, there only the data
+// that existed when the file was opened is mapped.
+void RegionFile::mapFile() noexcept
+{
+#ifdef _WIN32
+	HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(mFile)));
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) return;
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) return;
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		return;
+	}
+	mMappingHandle = mapping;
+	mMapping = static_cast<const uint8_t*>(view);
+	mMappingSize = size_t(fileSize.QuadPart);
+#else
+	void* view = mmap(nullptr, MAX_UNFRAGMENTED_FILE_SIZE, PROT_READ, MAP_SHARED, fileno(mFile), 0);
+	if (view == MAP_FAILED) return;
+	mMapping = static_cast<const uint8_t*>(view);
+	mMappingSize = MAX_UNFRAGMENTED_FILE_SIZE;
+#endif
+}
+
+void RegionFile::unmapFile() noexcept
+{
+	if (mMapping == nullptr) return;
+#ifdef _WIN32
+	UnmapViewOfFile(mMapping);
+	CloseHandle(static_cast<HANDLE>(mMappingHandle));
+	mMappingHandle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(mMapping), mMappingSize);
+#endif
+	mMapping = nullptr;
+	mMappingSize = 0;
+}
+
+bool RegionFile::writeEntry(size_t index, uint32_t entry) noexcept
+{
+	uint8_t bytes[4];
+	storeU32(bytes, entry);
+	if (std::fseek(mFile, long(TABLE_OFFSET + index * 4), SEEK_SET) != 0 ||
+	    std::fwrite(bytes, 1, 4, mFile) != 4 || std::fflush(mFile) != 0) {
+		return false;
+	}
+	mTable[index] = entry;
+	return true;
+}
+
+// First fit, a free run at the end of the file is extended
+size_t RegionFile::findFreeSectors(size_t numSectors) const noexcept
+{
+	size_t runStart = mUsedSectors.size(), runLength = 0;
+	for (size_t i = HEADER_SECTORS; i < mUsedSectors.size() && runLength < numSectors; i++) {
+		if (mUsedSectors[i]) {
+			runLength = 0;
+			continue;
+		}
+		if (runLength == 0) runStart = i;
+		runLength++;
+	}
+	if (runLength == 0) runStart = mUsedSectors.size();
+	return runStart;
+}
+
+void RegionFile::markSectors(uint32_t entry, bool used) noexcept
+{
+	const size_t first = firstSector(entry);
+	const size_t end = first + sectorsFor(dataSize(entry));
+	if (end > mUsedSectors.size()) mUsedSectors.resize(end, false);
+	for (size_t i = first; i < end; i++) mUsedSectors[i] = used;
+}
+
+} // namespace vox
@@ -0,0 +1,124 @@
+#pragma once
+#ifndef VOX_IO_REGION_FILE_HPP
+#define VOX_IO_REGION_FILE_HPP
+
+#include <bitset>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t, uint64_t
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+const size_t REGION_SIZE = 16; // Chunks along each axis of a region
+const size_t REGION_NUM_CHUNKS = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+const size_t REGION_SECTOR_SIZE = 256;
+const size_t REGION_MAX_CHUNK_SIZE = 4096; // Largest chunk in bytes
+const uint32_t REGION_VERSION = 2; // Files of other versions can't be opened
+
+/**
+ * @brief A file holding the data of up to REGION_NUM_CHUNKS chunks.
+ *
+ * The file is made of sectors of REGION_SECTOR_SIZE bytes. The first sectors are a header with a
+ * magic number, a version and an offset table of one 32-bit little endian entry per chunk:
+ * first sector << 12 | (size in bytes - 1), 0 if the chunk isn't stored. Each chunk occupies
+ * consecutive sectors. A chunk that still fits in its sectors is updated in place, otherwise it
+ * is moved to the first free run of sectors that fits, or to the end of the file.
+ *
+ * The file is also mapped read-only, so loads can decode chunks straight from the OS page cache,
+ * shared by every process that has the world open.
+ *
+ * All methods are thread safe.
+ */
+class RegionFile final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	RegionFile(const RegionFile&) = delete;
+	RegionFile& operator= (const RegionFile&) = delete;
+
+	RegionFile() noexcept = default;
+	~RegionFile() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/** @brief Opens the region file, creating it if it doesn't exist and create is true. */
+	bool open(const std::string& path, bool create) noexcept;
+	bool isOpen() const noexcept;
+
+	/**
+	 * @brief Copies the data of the chunk with the index to out (of REGION_MAX_CHUNK_SIZE bytes).
+	 * @return the size of the data, 0 if the chunk isn't stored or couldn't be read
+	 */
+	size_t read(size_t index, uint8_t* out) noexcept;
+
+	/**
+	 * @brief Returns the data of the chunk with the index inside the mapping of the file, nullptr if
+	 * the chunk isn't stored or isn't mapped (then use read()). The pointer stays valid until the
+	 * file is destroyed, but the data changes if the file is written, so decoding must not trust it.
+	 * @param numWrites set to numWrites() at the time of the call, if it differs from numWrites()
+	 * after using the data the file was written in the meantime and the data must be read again
+	 */
+	const uint8_t* mappedData(size_t index, size_t& size, uint64_t& numWrites) const noexcept;
+
+	/** @brief Returns the number of write() and erase() calls so far. */
+	uint64_t numWrites() const noexcept;
+
+	/** @brief Stores the data (1 to REGION_MAX_CHUNK_SIZE bytes) of the chunk with the index. */
+	bool write(size_t index, const uint8_t* data, size_t size) noexcept;
+
+	/** @brief Removes the chunk with the index, its sectors are reused by later writes. */
+	bool erase(size_t index) noexcept;
+
+	/** @brief Waits until everything written to the file has reached the disk. */
+	bool sync() noexcept;
+
+	/** @brief Returns the index in a region of the chunk with the offset (in chunks). */
+	static size_t chunkIndex(int x, int y, int z) noexcept;
+
+	/**
+	 * @brief Reads which chunks the region file stores from its header without opening it, bit i
+	 * for the chunk with index i. Returns false if the file doesn't exist or is invalid.
+	 */
+	static bool readStoredChunks(const std::string& path,
+	                             std::bitset<REGION_NUM_CHUNKS>& stored) noexcept;
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void mapFile() noexcept;
+	void unmapFile() noexcept;
+	bool writeEntry(size_t index, uint32_t entry) noexcept;
+	size_t findFreeSectors(size_t numSectors) const noexcept;
+	void markSectors(uint32_t entry, bool used) noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	mutable std::mutex mMutex;
+	std::string mPath;
+	std::FILE* mFile = nullptr;
+	uint64_t mNumWrites = 0;
+	const uint8_t* mMapping = nullptr;
+	size_t mMappingSize = 0;
+	void* mMappingHandle = nullptr; // Windows only
+	uint32_t mTable[REGION_NUM_CHUNKS];
+	vector<bool> mUsedSectors; // One per sector in the file, header included
+};
+
+} // namespace vox
+
+#endif
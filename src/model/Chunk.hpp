@@ -2,8 +2,10 @@
 #ifndef VOX_MODEL_CHUNK_HPP
 #define VOX_MODEL_CHUNK_HPP
 
+#include <algorithm> // std::fill_n
 #include <cstddef> // size_t
 #include <cstdint> // uint8_t
+#include <cstring> // std::memcpy
 #include <limits> //std::numeric_limits
 
 #include <sfz/Math.hpp>
@@ -17,6 +19,7 @@ namespace vox {
 
 using std::uint8_t;
 using std::uint16_t;
+using std::uint64_t;
 using std::size_t;
 using sfz::vec3;
 using sfz::vec3i;
@@ -33,6 +36,9 @@ struct ChunkIndex final {
 	ChunkIndex() noexcept = default;
 	inline ChunkIndex(uint16_t index) : mIndex{index} {}
 
+	/** @brief Returns the index of the voxel at the specified position, see chunkVoxelIndex(). */
+	static inline ChunkIndex fromPosition(size_t x, size_t y, size_t z) noexcept;
+
 	static inline uint16_t valueOfBit(uint16_t value, uint16_t position) noexcept
 	{
 		return (value >> position) & uint16_t(1);
@@ -54,6 +60,9 @@ struct ChunkIndex final {
 	inline uint16_t voxelY() const noexcept { return valueOfBit(mIndex, 1); }
 	inline uint16_t voxelZ() const noexcept { return valueOfBit(mIndex, 0); }
 
+	/** @brief Returns the position of the voxel inside its chunk, inverse of fromPosition(). */
+	inline vec3i position() const noexcept;
+
 	inline vec3 part8Offset() const noexcept;
 	inline vec3 part4Offset() const noexcept;
 	inline vec3 part2Offset() const noexcept;
@@ -75,46 +84,57 @@ struct ChunkIndex final {
 const ChunkIndex ChunkIterateBegin{0};
 const ChunkIndex ChunkIterateEnd{uint16_t(1) << 12};
 
-// ChunkParts
+// Morton encoding
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-class ChunkPart2 {
-private:
-	Voxel mVoxel[2][2][2];
-public:
-	inline Voxel getVoxel(size_t x, size_t y, size_t z) const noexcept;
-	inline Voxel getVoxel(const vec3i& offset) const noexcept;
-	inline Voxel getVoxel(ChunkIndex index) const noexcept;
-	inline void setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept;
-	inline void setVoxel(const vec3i& offset, Voxel voxel) noexcept;
-	inline void setVoxel(ChunkIndex index, Voxel voxel) noexcept;
-};
+const size_t CHUNK_NUM_VOXELS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
 
-struct ChunkPart4 {
-	ChunkPart2 mChunkPart2s[2][2][2];
-	inline const ChunkPart2* chunkPart2Ptr(const vec3i& offset) const noexcept
-	{
-		return &mChunkPart2s[offset[0]][offset[1]][offset[2]];
-	}
+// The bits of a coordinate spread out to its positions in a ChunkIndex, OR the three together to
+// get the index of a voxel.
+constexpr uint16_t CHUNK_MORTON_X[CHUNK_SIZE] = {
+	0x000, 0x004, 0x020, 0x024, 0x100, 0x104, 0x120, 0x124,
+	0x800, 0x804, 0x820, 0x824, 0x900, 0x904, 0x920, 0x924
+};
+constexpr uint16_t CHUNK_MORTON_Y[CHUNK_SIZE] = {
+	0x000, 0x002, 0x010, 0x012, 0x080, 0x082, 0x090, 0x092,
+	0x400, 0x402, 0x410, 0x412, 0x480, 0x482, 0x490, 0x492
+};
+constexpr uint16_t CHUNK_MORTON_Z[CHUNK_SIZE] = {
+	0x000, 0x001, 0x008, 0x009, 0x040, 0x041, 0x048, 0x049,
+	0x200, 0x201, 0x208, 0x209, 0x240, 0x241, 0x248, 0x249
 };
 
-struct ChunkPart8 {
-	ChunkPart4 mChunkPart4s[2][2][2];
-	inline const ChunkPart4* chunkPart4Ptr(const vec3i& offset) const noexcept
-	{
-		return &mChunkPart4s[offset[0]][offset[1]][offset[2]];
-	}
+/** @brief Returns the index of the voxel at the specified position in Chunk::mVoxels. */
+constexpr uint16_t chunkVoxelIndex(size_t x, size_t y, size_t z) noexcept
+{
+	return CHUNK_MORTON_X[x] | CHUNK_MORTON_Y[y] | CHUNK_MORTON_Z[z];
+}
+
+// Occupancy
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/** @brief Summary of a cube of voxels, AIR and SOLID mean that all voxels are air or non-air. */
+enum class Occupancy : uint8_t {
+	AIR,
+	MIXED,
+	SOLID
 };
 
 // Chunk
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
+/**
+ * @brief A 16x16x16 cube of voxels stored as a flat array in Morton (ChunkIndex) order.
+ *
+ * The order is the same as the old hierarchy of 8^3, 4^3 and 2^3 parts, so mVoxels is also the
+ * on-disk format of a chunk.
+ *
+ * The chunk also keeps the occupancy of each 8^3, 4^3 and 2^3 part, so that traversals can skip
+ * empty space. The setters keep it up to date, code writing to mVoxels directly must call
+ * updateOccupancy() afterwards.
+ */
 struct Chunk {
-	ChunkPart8 mChunkPart8s[2][2][2];
-	inline const ChunkPart8* chunkPart8Ptr(const vec3i& offset) const noexcept
-	{
-		return &mChunkPart8s[offset[0]][offset[1]][offset[2]];
-	}
+	Voxel mVoxels[CHUNK_NUM_VOXELS];
 
 	inline Chunk() noexcept;
 
@@ -123,6 +143,39 @@ struct Chunk {
 	inline Voxel getVoxel(ChunkIndex index) const noexcept;
 	inline void setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept;
 	inline void setVoxel(const vec3i& offset, Voxel voxel) noexcept;
+	inline void setVoxel(ChunkIndex index, Voxel voxel) noexcept;
+
+	/** @brief Copies the CHUNK_SIZE voxels with the specified x and y, ordered by z. */
+	inline void getRow(size_t x, size_t y, Voxel row[CHUNK_SIZE]) const noexcept;
+	inline void setRow(size_t x, size_t y, const Voxel row[CHUNK_SIZE]) noexcept;
+
+	/** @brief Copies the horizontal layer of voxels with the specified y, indexed [x][z]. */
+	inline void getSlab(size_t y, Voxel slab[CHUNK_SIZE][CHUNK_SIZE]) const noexcept;
+	inline void setSlab(size_t y, const Voxel slab[CHUNK_SIZE][CHUNK_SIZE]) noexcept;
+
+	inline void fill(Voxel voxel) noexcept;
+
+	/** @brief The occupancy of the part containing the voxel with the specified index. */
+	inline Occupancy part8Occupancy(ChunkIndex index) const noexcept;
+	inline Occupancy part4Occupancy(ChunkIndex index) const noexcept;
+	inline Occupancy part2Occupancy(ChunkIndex index) const noexcept;
+	inline Occupancy occupancy() const noexcept;
+
+	/** @brief Returns whether all voxels in the chunk are of the same type. */
+	inline bool uniform() const noexcept;
+
+	/** @brief Recalculates the occupancy of all parts from mVoxels. */
+	inline void updateOccupancy() noexcept;
+
+private:
+	inline void updatePartOccupancy(uint16_t index) noexcept;
+
+	// One bit per part (in ChunkIndex order) for whether it contains any non-air voxel and for
+	// whether it contains any air voxel. A chunk of only air is the default.
+	uint64_t mPart2HasSolid[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	uint64_t mPart2HasAir[8] = {~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull, ~0ull};
+	uint64_t mPart4HasSolid = 0, mPart4HasAir = ~0ull;
+	uint8_t mPart8HasSolid = 0, mPart8HasAir = 0xFF;
 };
 
 // Chunk AABB calculators
@@ -2,9 +2,45 @@
 
 namespace vox {
 
+// Occupancy helpers
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline Occupancy occupancyFromBits(bool hasSolid, bool hasAir) noexcept
+{
+	if (!hasSolid) return Occupancy::AIR;
+	if (!hasAir) return Occupancy::SOLID;
+	return Occupancy::MIXED;
+}
+
+// Returns whether any of the 8 bytes is zero, i.e. whether a 2^3 part contains any air.
+inline bool anyZeroByte(uint64_t bytes) noexcept
+{
+	const uint64_t ONES = 0x0101010101010101ull;
+	const uint64_t HIGHS = 0x8080808080808080ull;
+	return ((bytes - ONES) & ~bytes & HIGHS) != 0;
+}
+
 // ChunkIndex & iterators
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
+inline ChunkIndex ChunkIndex::fromPosition(size_t x, size_t y, size_t z) noexcept
+{
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	sfz_assert_debug(z < CHUNK_SIZE);
+	return ChunkIndex{chunkVoxelIndex(x, y, z)};
+}
+
+inline vec3i ChunkIndex::position() const noexcept
+{
+	// Gathers every third bit, starting at the lowest bit of the axis, into a 4 bit coordinate
+	auto compact = [](int bits) -> int {
+		return (bits & 1) | ((bits >> 2) & 2) | ((bits >> 4) & 4) | ((bits >> 6) & 8);
+	};
+	const int i = mIndex;
+	return vec3i{compact(i >> 2), compact(i >> 1), compact(i)};
+}
+
 inline vec3 ChunkIndex::part8Offset() const noexcept
 {
 	return vec3{static_cast<float>(part8X()*8),
@@ -28,23 +64,32 @@ inline vec3 ChunkIndex::part2Offset() const noexcept
 
 inline vec3 ChunkIndex::voxelOffset() const noexcept
 {
-	return vec3{static_cast<float>(part8X()*8 + part4X()*4 + part2X()*2 + voxelX()),
-	             static_cast<float>(part8Y()*8 + part4Y()*4 + part2Y()*2 + voxelY()),
-	             static_cast<float>(part8Z()*8 + part4Z()*4 + part2Z()*2 + voxelZ())};
+	const vec3i p = position();
+	return vec3{static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2])};
+}
+
+// Chunk: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline Chunk::Chunk() noexcept
+{
+	static_assert(sizeof(Voxel) == 1, "Voxel is padded.");
+	static_assert(sizeof(mVoxels) == 4096, "Chunk is padded.");
+	static_assert(VOXEL_AIR == 0, "Occupancy assumes air is the zero byte.");
 }
 
-// ChunkPart2: Getters & setters
+// Chunk: Getters & setters
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-inline Voxel ChunkPart2::getVoxel(size_t x, size_t y, size_t z) const noexcept
+inline Voxel Chunk::getVoxel(size_t x, size_t y, size_t z) const noexcept
 {
-	sfz_assert_debug(x < 2);
-	sfz_assert_debug(y < 2);
-	sfz_assert_debug(z < 2);
-	return mVoxel[x][y][z];
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	sfz_assert_debug(z < CHUNK_SIZE);
+	return mVoxels[chunkVoxelIndex(x, y, z)];
 }
 
-inline Voxel ChunkPart2::getVoxel(const vec3i& offset) const noexcept
+inline Voxel Chunk::getVoxel(const vec3i& offset) const noexcept
 {
 	sfz_assert_debug(0 <= offset[0]);
 	sfz_assert_debug(0 <= offset[1]);
@@ -52,20 +97,23 @@ inline Voxel ChunkPart2::getVoxel(const vec3i& offset) const noexcept
 	return getVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2]);
 }
 
-inline Voxel ChunkPart2::getVoxel(ChunkIndex index) const noexcept
+inline Voxel Chunk::getVoxel(ChunkIndex i) const noexcept
 {
-	return mVoxel[index.voxelX()][index.voxelY()][index.voxelZ()];
+	sfz_assert_debug(i.mIndex < ChunkIterateEnd.mIndex);
+	return mVoxels[i.mIndex];
 }
 
-inline void ChunkPart2::setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept
+inline void Chunk::setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept
 {
-	sfz_assert_debug(x < 2);
-	sfz_assert_debug(y < 2);
-	sfz_assert_debug(z < 2);
-	mVoxel[x][y][z] = voxel;
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	sfz_assert_debug(z < CHUNK_SIZE);
+	const uint16_t index = chunkVoxelIndex(x, y, z);
+	mVoxels[index] = voxel;
+	updatePartOccupancy(index);
 }
 
-inline void ChunkPart2::setVoxel(const vec3i& offset, Voxel voxel) noexcept
+inline void Chunk::setVoxel(const vec3i& offset, Voxel voxel) noexcept
 {
 	sfz_assert_debug(0 <= offset[0]);
 	sfz_assert_debug(0 <= offset[1]);
@@ -73,139 +121,167 @@ inline void ChunkPart2::setVoxel(const vec3i& offset, Voxel voxel) noexcept
 	setVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2], voxel);
 }
 
-inline void ChunkPart2::setVoxel(ChunkIndex index, Voxel voxel) noexcept
+inline void Chunk::setVoxel(ChunkIndex i, Voxel voxel) noexcept
 {
-	mVoxel[index.voxelX()][index.voxelY()][index.voxelZ()] = voxel;
+	sfz_assert_debug(i.mIndex < ChunkIterateEnd.mIndex);
+	mVoxels[i.mIndex] = voxel;
+	updatePartOccupancy(i.mIndex);
 }
 
-// Chunk: Constructors & destructors
+// Chunk: Bulk accessors
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-inline Chunk::Chunk() noexcept
+inline void Chunk::getRow(size_t x, size_t y, Voxel row[CHUNK_SIZE]) const noexcept
 {
-	static_assert(sizeof(Voxel) == 1, "Voxel is padded.");
-	static_assert(sizeof(ChunkPart2) == 8, "ChunkPart2 is padded.");
-	static_assert(sizeof(ChunkPart4) == 64, "ChunkPart4 is padded.");
-	static_assert(sizeof(ChunkPart8) == 512, "ChunkPart8 is padded.");
-	static_assert(sizeof(Chunk) == 4096, "Chunk is padded.");
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	const Voxel* base = mVoxels + (CHUNK_MORTON_X[x] | CHUNK_MORTON_Y[y]);
+	for (size_t z = 0; z < CHUNK_SIZE; z++) {
+		row[z] = base[CHUNK_MORTON_Z[z]];
+	}
 }
 
-// Chunk: Getters & setters
-// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
-
-inline Voxel Chunk::getVoxel(size_t x, size_t y, size_t z) const noexcept
+inline void Chunk::setRow(size_t x, size_t y, const Voxel row[CHUNK_SIZE]) noexcept
 {
 	sfz_assert_debug(x < CHUNK_SIZE);
 	sfz_assert_debug(y < CHUNK_SIZE);
-	sfz_assert_debug(z < CHUNK_SIZE);
+	Voxel* base = mVoxels + (CHUNK_MORTON_X[x] | CHUNK_MORTON_Y[y]);
+	for (size_t z = 0; z < CHUNK_SIZE; z++) {
+		base[CHUNK_MORTON_Z[z]] = row[z];
+	}
+	// Each 2^3 part contains two voxels of the row
+	for (size_t z = 0; z < CHUNK_SIZE; z += 2) {
+		updatePartOccupancy(uint16_t((base - mVoxels) + CHUNK_MORTON_Z[z]));
+	}
+}
 
-	size_t xi, yi, zi;
-	
-	if (x < 8) xi = 0;
-	else xi = 1;
-	if (y < 8) yi = 0;
-	else yi = 1;
-	if (z < 8) zi = 0;
-	else zi = 1;
-	const ChunkPart8* part8 = &mChunkPart8s[xi][yi][zi];
-
-	x %= 8;
-	y %= 8;
-	z %= 8;
-	if (x < 4) xi = 0;
-	else xi = 1;
-	if (y < 4) yi = 0;
-	else yi = 1;
-	if (z < 4) zi = 0;
-	else zi = 1;
-	const ChunkPart4* part4 = &part8->mChunkPart4s[xi][yi][zi];
-
-	x %= 4;
-	y %= 4;
-	z %= 4;
-	if (x < 2) xi = 0;
-	else xi = 1;
-	if (y < 2) yi = 0;
-	else yi = 1;
-	if (z < 2) zi = 0;
-	else zi = 1;
-	const ChunkPart2* part2 = &part4->mChunkPart2s[xi][yi][zi];
-
-	x %= 2;
-	y %= 2;
-	z %= 2;
-
-	return part2->getVoxel(x, y, z);
+inline void Chunk::getSlab(size_t y, Voxel slab[CHUNK_SIZE][CHUNK_SIZE]) const noexcept
+{
+	for (size_t x = 0; x < CHUNK_SIZE; x++) {
+		getRow(x, y, slab[x]);
+	}
 }
 
-inline Voxel Chunk::getVoxel(const vec3i& offset) const noexcept
+inline void Chunk::setSlab(size_t y, const Voxel slab[CHUNK_SIZE][CHUNK_SIZE]) noexcept
 {
-	sfz_assert_debug(0 <= offset[0]);
-	sfz_assert_debug(0 <= offset[1]);
-	sfz_assert_debug(0 <= offset[2]);
-	return getVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2]);
+	for (size_t x = 0; x < CHUNK_SIZE; x++) {
+		setRow(x, y, slab[x]);
+	}
 }
 
-inline Voxel Chunk::getVoxel(ChunkIndex i) const noexcept
+inline void Chunk::fill(Voxel voxel) noexcept
 {
-	sfz_assert_debug(i.mIndex < ChunkIterateEnd.mIndex);
-	const ChunkPart8* part8 = &mChunkPart8s[i.part8X()][i.part8Y()][i.part8Z()];
-	const ChunkPart4* part4 = &part8->mChunkPart4s[i.part4X()][i.part4Y()][i.part4Z()];
-	const ChunkPart2* part2 = &part4->mChunkPart2s[i.part2X()][i.part2Y()][i.part2Z()];
-	return part2->getVoxel(i);
+	std::fill_n(mVoxels, CHUNK_NUM_VOXELS, voxel);
+	const bool solid = voxel.mType != VOXEL_AIR;
+	for (size_t i = 0; i < 8; i++) {
+		mPart2HasSolid[i] = solid ? ~0ull : 0;
+		mPart2HasAir[i] = solid ? 0 : ~0ull;
+	}
+	mPart4HasSolid = solid ? ~0ull : 0;
+	mPart4HasAir = solid ? 0 : ~0ull;
+	mPart8HasSolid = solid ? 0xFF : 0;
+	mPart8HasAir = solid ? 0 : 0xFF;
 }
 
-inline void Chunk::setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept
+// Chunk: Occupancy
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline Occupancy Chunk::part8Occupancy(ChunkIndex index) const noexcept
 {
-	sfz_assert_debug(x < CHUNK_SIZE);
-	sfz_assert_debug(y < CHUNK_SIZE);
-	sfz_assert_debug(z < CHUNK_SIZE);
+	const size_t part = index.mIndex >> 9;
+	return occupancyFromBits(((mPart8HasSolid >> part) & 1) != 0, ((mPart8HasAir >> part) & 1) != 0);
+}
 
-	size_t xi, yi, zi;
-	
-	if (x < 8) xi = 0;
-	else xi = 1;
-	if (y < 8) yi = 0;
-	else yi = 1;
-	if (z < 8) zi = 0;
-	else zi = 1;
-	ChunkPart8* part8 = &mChunkPart8s[xi][yi][zi];
-
-	x %= 8;
-	y %= 8;
-	z %= 8;
-	if (x < 4) xi = 0;
-	else xi = 1;
-	if (y < 4) yi = 0;
-	else yi = 1;
-	if (z < 4) zi = 0;
-	else zi = 1;
-	ChunkPart4* part4 = &part8->mChunkPart4s[xi][yi][zi];
-
-	x %= 4;
-	y %= 4;
-	z %= 4;
-	if (x < 2) xi = 0;
-	else xi = 1;
-	if (y < 2) yi = 0;
-	else yi = 1;
-	if (z < 2) zi = 0;
-	else zi = 1;
-	ChunkPart2* part2 = &part4->mChunkPart2s[xi][yi][zi];
-
-	x %= 2;
-	y %= 2;
-	z %= 2;
-
-	part2->setVoxel(x, y, z, voxel);
+inline Occupancy Chunk::part4Occupancy(ChunkIndex index) const noexcept
+{
+	const size_t part = index.mIndex >> 6;
+	return occupancyFromBits(((mPart4HasSolid >> part) & 1) != 0, ((mPart4HasAir >> part) & 1) != 0);
 }
 
-inline void Chunk::setVoxel(const vec3i& offset, Voxel voxel) noexcept
+inline Occupancy Chunk::part2Occupancy(ChunkIndex index) const noexcept
 {
-	sfz_assert_debug(0 <= offset[0]);
-	sfz_assert_debug(0 <= offset[1]);
-	sfz_assert_debug(0 <= offset[2]);
-	setVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2], voxel);
+	const size_t part = index.mIndex >> 3;
+	return occupancyFromBits(((mPart2HasSolid[part >> 6] >> (part & 63)) & 1) != 0,
+	                         ((mPart2HasAir[part >> 6] >> (part & 63)) & 1) != 0);
+}
+
+inline Occupancy Chunk::occupancy() const noexcept
+{
+	return occupancyFromBits(mPart8HasSolid != 0, mPart8HasAir != 0);
+}
+
+inline bool Chunk::uniform() const noexcept
+{
+	const Occupancy chunkOccupancy = occupancy();
+	if (chunkOccupancy != Occupancy::SOLID) return chunkOccupancy == Occupancy::AIR;
+
+	// Every 8 bytes compared at once against the first voxel repeated 8 times
+	const uint64_t first = uint64_t(mVoxels[0].mType) * 0x0101010101010101ull;
+	for (size_t i = 0; i < CHUNK_NUM_VOXELS; i += 8) {
+		uint64_t bytes;
+		std::memcpy(&bytes, mVoxels + i, sizeof(bytes));
+		if (bytes != first) return false;
+	}
+	return true;
+}
+
+inline void Chunk::updateOccupancy() noexcept
+{
+	// The 8 voxels of a 2^3 part are contiguous, so each part is tested as one 64-bit word
+	for (size_t i = 0; i < 8; i++) {
+		uint64_t hasSolid = 0, hasAir = 0;
+		for (size_t j = 0; j < 64; j++) {
+			uint64_t bytes;
+			std::memcpy(&bytes, mVoxels + (i * 64 + j) * 8, sizeof(bytes));
+			hasSolid |= uint64_t(bytes != 0) << j;
+			hasAir |= uint64_t(anyZeroByte(bytes)) << j;
+		}
+		mPart2HasSolid[i] = hasSolid;
+		mPart2HasAir[i] = hasAir;
+	}
+
+	mPart4HasSolid = 0;
+	mPart4HasAir = 0;
+	for (size_t part4 = 0; part4 < 64; part4++) {
+		const size_t shift = (part4 & 7) * 8;
+		mPart4HasSolid |= uint64_t(((mPart2HasSolid[part4 >> 3] >> shift) & 0xFF) != 0) << part4;
+		mPart4HasAir |= uint64_t(((mPart2HasAir[part4 >> 3] >> shift) & 0xFF) != 0) << part4;
+	}
+
+	mPart8HasSolid = 0;
+	mPart8HasAir = 0;
+	for (size_t part8 = 0; part8 < 8; part8++) {
+		mPart8HasSolid |= uint8_t((((mPart4HasSolid >> (part8 * 8)) & 0xFF) != 0) << part8);
+		mPart8HasAir |= uint8_t((((mPart4HasAir >> (part8 * 8)) & 0xFF) != 0) << part8);
+	}
+}
+
+inline void Chunk::updatePartOccupancy(uint16_t index) noexcept
+{
+	// The 2^3 part from its voxels, then each parent from the 8 bits of its children
+	const size_t part2 = index >> 3;
+	uint64_t bytes;
+	std::memcpy(&bytes, mVoxels + part2 * 8, sizeof(bytes));
+	const uint64_t bit2 = uint64_t(1) << (part2 & 63);
+	uint64_t& part2HasSolid = mPart2HasSolid[part2 >> 6];
+	uint64_t& part2HasAir = mPart2HasAir[part2 >> 6];
+	part2HasSolid = bytes != 0 ? (part2HasSolid | bit2) : (part2HasSolid & ~bit2);
+	part2HasAir = anyZeroByte(bytes) ? (part2HasAir | bit2) : (part2HasAir & ~bit2);
+
+	const size_t part4 = index >> 6;
+	const size_t shift4 = (part4 & 7) * 8;
+	const uint64_t bit4 = uint64_t(1) << part4;
+	mPart4HasSolid = ((part2HasSolid >> shift4) & 0xFF) != 0 ? (mPart4HasSolid | bit4)
+	                                                          : (mPart4HasSolid & ~bit4);
+	mPart4HasAir = ((part2HasAir >> shift4) & 0xFF) != 0 ? (mPart4HasAir | bit4)
+	                                                      : (mPart4HasAir & ~bit4);
+
+	const size_t part8 = index >> 9;
+	const uint8_t bit8 = uint8_t(1 << part8);
+	mPart8HasSolid = ((mPart4HasSolid >> (part8 * 8)) & 0xFF) != 0 ? uint8_t(mPart8HasSolid | bit8)
+	                                                                : uint8_t(mPart8HasSolid & ~bit8);
+	mPart8HasAir = ((mPart4HasAir >> (part8 * 8)) & 0xFF) != 0 ? uint8_t(mPart8HasAir | bit8)
+	                                                            : uint8_t(mPart8HasAir & ~bit8);
 }
 
 // Chunk AABB calculators
@@ -0,0 +1,158 @@
+#include "model/ChunkLoader.hpp"
+
+#include <algorithm> // std::sort, std::max
+
+
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+size_t defaultNumThreads() noexcept
+{
+	// Leave one hardware thread for the main (render) thread
+	size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+}
+
+inline int squaredDistance(const vec3i& lhs, const vec3i& rhs) noexcept
+{
+	vec3i diff = lhs - rhs;
+	return sfz::dot(diff, diff);
+}
+
+inline bool outside(const vec3i& offset, const vec3i& min, const vec3i& max) noexcept
+{
+	return (offset[0] < min[0] || max[0] < offset[0]) ||
+	       (offset[1] < min[1] || max[1] < offset[1]) ||
+	       (offset[2] < min[2] || max[2] < offset[2]);
+}
+
+} // anonymous namespace
+
+// ChunkLoader: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+ChunkLoader::ChunkLoader(ChunkStorage& storage, const ChunkWriter& writer,
+                         const TerrainSettings& terrain, size_t numThreads) noexcept
+:
+	mStorage(storage),
+	mWriter(writer),
+	mGenerator{createTerrainGenerator(terrain)},
+	mCenter{0, 0, 0},
+	mMin{0, 0, 0},
+	mMax{0, 0, 0}
+{
+	if (numThreads == 0) numThreads = defaultNumThreads();
+	for (size_t i = 0; i < numThreads; i++) {
+		mThreads.emplace_back(&ChunkLoader::workerLoop, this);
+	}
+}
+
+ChunkLoader::~ChunkLoader() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	for (std::thread& thread : mThreads) {
+		thread.join();
+	}
+}
+
+// ChunkLoader: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkLoader::setRange(const vec3i& center, const vec3i& min, const vec3i& max) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	mCenter = center;
+	mMin = min;
+	mMax = max;
+	mQueueSorted = false;
+}
+
+void ChunkLoader::request(const vec3i& offset) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		mQueue.push_back(offset);
+		mQueueSorted = false;
+	}
+	mCondition.notify_one();
+}
+
+size_t ChunkLoader::takeFinished(vector<LoadedChunk>& out, size_t maxNumChunks) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	size_t numTaken = mFinished.size();
+	if (maxNumChunks != 0 && maxNumChunks < numTaken) numTaken = maxNumChunks;
+	out.insert(out.end(), mFinished.begin(), mFinished.begin() + numTaken);
+	mFinished.erase(mFinished.begin(), mFinished.begin() + numTaken);
+	return numTaken;
+}
+
+size_t ChunkLoader::numPending() const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	return mQueue.size() + mNumInProgress + mFinished.size();
+}
+
+// ChunkLoader: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkLoader::workerLoop() noexcept
+{
+	LoadedChunk loaded;
+
+	// Jobs are sorted by distance, so consecutive jobs are often in the same column of chunks
+	ChunkHeightmap heightmap;
+	vec3i heightmapOffset{0, 0, 0};
+	bool hasHeightmap = false;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock{mMutex};
+			mCondition.wait(lock, [this]() { return !mRunning || !mQueue.empty(); });
+			if (!mRunning) return;
+
+			if (!mQueueSorted) {
+				const vec3i center = mCenter;
+				std::sort(mQueue.begin(), mQueue.end(), [&center](const vec3i& lhs, const vec3i& rhs) {
+					return squaredDistance(lhs, center) > squaredDistance(rhs, center);
+				});
+				mQueueSorted = true;
+			}
+
+			loaded.offset = mQueue.back();
+			mQueue.pop_back();
+			if (outside(loaded.offset, mMin, mMax)) continue;
+			mNumInProgress++;
+		}
+
+		const vec3i& o = loaded.offset;
+		loaded.generated = !mWriter.pendingChunk(o, loaded.chunk) &&
+		                   !mStorage.readChunk(loaded.chunk, o, *mGenerator);
+		if (loaded.generated) {
+			if (!hasHeightmap || heightmapOffset[0] != o[0] || heightmapOffset[2] != o[2]) {
+				heightmap = mGenerator->generateHeightmap(o[0], o[2]);
+				heightmapOffset = o;
+				hasHeightmap = true;
+			}
+			// Not stored, generated again every time it is loaded until it is modified
+			loaded.chunk = mGenerator->generateChunk(heightmap, o);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{mMutex};
+			mFinished.push_back(loaded);
+			mNumInProgress--;
+		}
+	}
+}
+
+} // namespace vox
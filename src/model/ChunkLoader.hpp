@@ -0,0 +1,117 @@
+#pragma once
+#ifndef VOX_MODEL_CHUNK_LOADER_HPP
+#define VOX_MODEL_CHUNK_LOADER_HPP
+
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sfz/Math.hpp>
+
+#include "model/Chunk.hpp"
+#include "model/ChunkWriter.hpp"
+#include "model/TerrainGenerator.hpp"
+#include "io/ChunkIO.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::unique_ptr;
+using std::vector;
+using sfz::vec3i;
+
+// LoadedChunk
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+struct LoadedChunk final {
+	vec3i offset;
+	Chunk chunk;
+	bool generated; // True if chunk didn't exist on disk and was generated
+};
+
+// ChunkLoader
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief Pool of worker threads that read (or generate) chunks in the background.
+ *
+ * Generated chunks are never written, only chunks that have been modified are stored on disk.
+ * Modified chunks the ChunkWriter hasn't written yet are taken from the writer.
+ *
+ * Requested chunks are loaded in order of distance to the current center, requests that fall
+ * outside the current range before a worker gets to them are dropped. Finished chunks are staged
+ * inside the loader until the owner (World) takes them on the main thread.
+ */
+class ChunkLoader final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkLoader() = delete;
+	ChunkLoader(const ChunkLoader&) = delete;
+	ChunkLoader& operator= (const ChunkLoader&) = delete;
+
+	/**
+	 * @param storage the stored chunks of the world, must outlive the loader
+	 * @param writer the writer of the world, its pending chunks are newer than storage
+	 * @param terrain the generator used for chunks that aren't stored
+	 * @param numThreads number of worker threads, 0 to select based on hardware
+	 */
+	ChunkLoader(ChunkStorage& storage, const ChunkWriter& writer, const TerrainSettings& terrain,
+	            size_t numThreads = 0) noexcept;
+	~ChunkLoader() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/** @brief Sets the center used for prioritizing and the range outside of which jobs are dropped. */
+	void setRange(const vec3i& center, const vec3i& min, const vec3i& max) noexcept;
+
+	/** @brief Queues the chunk at the specified offset for loading. */
+	void request(const vec3i& offset) noexcept;
+
+	/**
+	 * @brief Moves finished chunks to the end of the out vector, returns number moved.
+	 * @param maxNumChunks the maximum number of chunks to move, 0 for all
+	 */
+	size_t takeFinished(vector<LoadedChunk>& out, size_t maxNumChunks = 0) noexcept;
+
+	/** @brief Returns number of requested chunks not yet taken (queued, in progress or finished). */
+	size_t numPending() const noexcept;
+
+	inline size_t numThreads() const noexcept { return mThreads.size(); }
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void workerLoop() noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkStorage& mStorage;
+	const ChunkWriter& mWriter;
+	const unique_ptr<TerrainGenerator> mGenerator;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mRunning = true;
+
+	vec3i mCenter, mMin, mMax;
+	bool mQueueSorted = true;
+	vector<vec3i> mQueue; // Sorted so that the job closest to center is at the back
+	size_t mNumInProgress = 0;
+	std::deque<LoadedChunk> mFinished;
+
+	vector<std::thread> mThreads;
+};
+
+} // namespace vox
+
+#endif
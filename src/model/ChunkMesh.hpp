@@ -2,21 +2,32 @@
 #ifndef VOX_MODEL_CHUNK_MESH_HPP
 #define VOX_MODEL_CHUNK_MESH_HPP
 
-#include <sfz/math/Vector.hpp>
+#include <cstddef> // size_t
+#include <vector>
+
 #include "model/Chunk.hpp"
-#include <memory>
+#include "model/ChunkMeshBuilder.hpp"
 
 
 
 namespace vox {
 
-using sfz::vec2;
-using sfz::vec3;
-using std::unique_ptr;
+using std::size_t;
+using std::vector;
 
 // ChunkMesh
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
+/**
+ * @brief GPU mesh of a chunk, each vertex is packed into a single uint32_t (attribute location 3).
+ * Layout from least significant bit: x (5 bits), y (5 bits), z (5 bits), face (3 bits, order
+ * -x, +x, -y, +y, -z, +z) and material (8 bits, the voxel type). Normal, UV coordinates and texture
+ * atlas region are derived from face and material in the shaders.
+ *
+ * All meshes share one immutable index buffer, each mesh only owns a vertex buffer of roughly its
+ * actual size. The buffer holds the segments (see ChunkMeshSegments) one after another with some
+ * slack, so that a single rebuilt segment can usually be uploaded without touching the others.
+ */
 class ChunkMesh final {
 public:
 
@@ -32,22 +43,46 @@ public:
 	// Public methods
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-	void set(const Chunk& chunk) noexcept;
+	/**
+	 * @brief Replaces the segments in segmentMask with the ones in vertices, other segments are kept.
+	 * Segments that still fit in their part of the vertex buffer are uploaded with glBufferSubData(),
+	 * otherwise the whole buffer is laid out again.
+	 * @param segments where in vertices each segment is, see ChunkMeshBuilder::segments()
+	 */
+	void upload(const uint32_t* vertices, const ChunkMeshSegments& segments,
+	            uint8_t segmentMask = CHUNK_MESH_ALL_SEGMENTS) noexcept;
+
+	/** @brief Makes the mesh empty until the next upload, keeps the GPU buffer. */
+	void clear() noexcept;
+
 	void render() const noexcept;
 
+	// Getters
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	inline size_t numVoxels() const noexcept { return mCurrentNumVoxels; }
+	inline size_t numVertices() const noexcept { return mCurrentNumFaces * 4; }
+	inline size_t numTriangles() const noexcept { return mCurrentNumFaces * 2; }
+	inline size_t vertexDataSize() const noexcept { return numVertices() * sizeof(uint32_t); }
+
+	// The number of vertices and triangles if every face of every voxel had been included
+	inline size_t numVerticesUnculled() const noexcept { return mCurrentNumVoxels * 24; }
+	inline size_t numTrianglesUnculled() const noexcept { return mCurrentNumVoxels * 12; }
+
 private:
 	// Private members
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
 	unsigned int mVAO;
-	unsigned int mVertexBuffer, mNormalBuffer, mUVBuffer, mIndexBuffer;
-
-	size_t mCurrentNumVoxels = 0;
-	const size_t mNumVoxelsPerChunk, mDataArraySize, mIndicesArraySize;
-	const unique_ptr<vec3[]> mVertexArray;
-	const unique_ptr<vec3[]> mNormalArray;
-	const unique_ptr<vec2[]> mUVArray;
-	const unique_ptr<unsigned int[]> mIndexArray;
+	unsigned int mVertexBuffer;
+
+	size_t mCurrentNumVoxels = 0, mCurrentNumFaces = 0;
+
+	// Per segment: CPU copy of the vertices, and where in the vertex buffer it goes (in faces)
+	vector<uint32_t> mSegmentVertices[CHUNK_MESH_NUM_SEGMENTS];
+	size_t mSegmentNumVoxels[CHUNK_MESH_NUM_SEGMENTS];
+	size_t mSegmentBegin[CHUNK_MESH_NUM_SEGMENTS];
+	size_t mSegmentCapacity[CHUNK_MESH_NUM_SEGMENTS];
 };
 
 } // namespace vox
@@ -0,0 +1,295 @@
+#include "model/ChunkMeshBuilder.hpp"
+
+#include <new> // std::nothrow
+
+#include <sfz/Assert.hpp>
+
+
+
+namespace vox {
+
+// Anonymous namespace
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+// The six faces of a cube in the order: left (-x), right (+x), bottom (-y), top (+y), back (-z) and
+// front (+z). The vertices of each face are ordered so that all faces share the same indices.
+
+const vec3i FACE_DIRECTIONS[] = {
+	vec3i{-1, 0, 0}, // Left
+	vec3i{1, 0, 0}, // Right
+	vec3i{0, -1, 0}, // Bottom
+	vec3i{0, 1, 0}, // Top
+	vec3i{0, 0, -1}, // Back
+	vec3i{0, 0, 1} // Front
+};
+
+const vec3i FACE_VERTICES[][4] = {
+	// x, y, z
+	// Left
+	{vec3i{0, 0, 0}, // left-bottom-back
+	 vec3i{0, 0, 1}, // left-bottom-front
+	 vec3i{0, 1, 0}, // left-top-back
+	 vec3i{0, 1, 1}}, // left-top-front
+
+	// Right
+	{vec3i{1, 0, 1}, // right-bottom-front
+	 vec3i{1, 0, 0}, // right-bottom-back
+	 vec3i{1, 1, 1}, // right-top-front
+	 vec3i{1, 1, 0}}, // right-top-back
+
+	// Bottom
+	{vec3i{0, 0, 0}, // left-bottom-back
+	 vec3i{1, 0, 0}, // right-bottom-back
+	 vec3i{0, 0, 1}, // left-bottom-front
+	 vec3i{1, 0, 1}}, // right-bottom-front
+
+	// Top
+	{vec3i{0, 1, 1}, // left-top-front
+	 vec3i{1, 1, 1}, // right-top-front
+	 vec3i{0, 1, 0}, // left-top-back
+	 vec3i{1, 1, 0}}, // right-top-back
+
+	// Back
+	{vec3i{1, 0, 0}, // right-bottom-back
+	 vec3i{0, 0, 0}, // left-bottom-back
+	 vec3i{1, 1, 0}, // right-top-back
+	 vec3i{0, 1, 0}}, // left-top-back
+
+	// Front
+	{vec3i{0, 0, 1}, // left-bottom-front
+	 vec3i{1, 0, 1}, // right-bottom-front
+	 vec3i{0, 1, 1}, // left-top-front
+	 vec3i{1, 1, 1}} // right-top-front
+};
+
+const uint16_t FACE_INDICES[] = {
+	0, 1, 2,
+	3, 2, 1
+};
+
+const size_t NUM_CUBE_FACES = 6;
+const size_t SEGMENT_SIZE = CHUNK_SIZE / 2;
+
+static_assert(sizeof(FACE_INDICES)/sizeof(uint16_t) == CHUNK_MESH_FACE_INDICES, "FACE_INDICES is wrong size");
+static_assert(CHUNK_MESH_MAX_NUM_VERTICES <= 65536, "Chunk mesh vertices can't be indexed with uint16_t");
+static_assert(CHUNK_SIZE < 32, "Vertex positions don't fit in 5 bits");
+
+// See ChunkMesh for the layout, decoded in gbuffer_gen.vert and shadow_map.vert
+inline uint32_t packVertex(const vec3i& position, size_t face, uint8_t material) noexcept
+{
+	sfz_assert_debug(0 <= position[0] && position[0] <= (int)CHUNK_SIZE);
+	sfz_assert_debug(0 <= position[1] && position[1] <= (int)CHUNK_SIZE);
+	sfz_assert_debug(0 <= position[2] && position[2] <= (int)CHUNK_SIZE);
+	return uint32_t(position[0]) | (uint32_t(position[1]) << 5) | (uint32_t(position[2]) << 10) |
+	       (uint32_t(face) << 15) | (uint32_t(material) << 18);
+}
+
+// Returns the voxel at position, which may be up to one step outside the chunk in the specified
+// face direction. Such voxels are looked up in the neighbouring chunk, missing chunks count as air.
+Voxel voxelTowards(const Chunk& chunk, const Chunk* const neighbours[6], size_t face,
+                   vec3i pos) noexcept
+{
+	const Chunk* chunkPtr = &chunk;
+	for (size_t i = 0; i < 3; i++) {
+		if (pos[i] < 0 || pos[i] >= (int)CHUNK_SIZE) {
+			chunkPtr = neighbours[face];
+			pos[i] = (pos[i] + (int)CHUNK_SIZE) % (int)CHUNK_SIZE;
+		}
+	}
+	if (chunkPtr == nullptr) return Voxel{VOXEL_AIR};
+	return chunkPtr->getVoxel(pos);
+}
+
+// Returns whether the neighbour of the voxel at position in the specified face direction is air.
+inline bool faceVisible(const Chunk& chunk, const Chunk* const neighbours[6], size_t face,
+                        const vec3i& position) noexcept
+{
+	return voxelTowards(chunk, neighbours, face, position + FACE_DIRECTIONS[face]).mType == VOXEL_AIR;
+}
+
+} // anonymous namespace
+
+// ChunkMeshBuilder: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+ChunkMeshBuilder::ChunkMeshBuilder() noexcept
+:
+	mVertices{new (std::nothrow) uint32_t[CHUNK_MESH_MAX_NUM_VERTICES]}
+{ }
+
+// ChunkMeshBuilder: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkMeshBuilder::build(const Chunk& chunk, const Chunk* const neighbours[6], MeshingMode mode,
+                             uint8_t segmentMask) noexcept
+{
+	static const Chunk* const NO_NEIGHBOURS[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+	if (neighbours == nullptr) neighbours = NO_NEIGHBOURS;
+
+	mNumFaces = 0;
+	mNumVoxels = 0;
+
+	for (size_t segment = 0; segment < CHUNK_MESH_NUM_SEGMENTS; segment++) {
+		mSegments.begin[segment] = mNumFaces;
+		mSegments.numFaces[segment] = 0;
+		mSegments.numVoxels[segment] = 0;
+		if ((segmentMask & (1 << segment)) == 0) continue;
+
+		// Segments are ChunkPart8s, which are contiguous ranges of ChunkIndex
+		const size_t numVoxelsBefore = mNumVoxels;
+		ChunkIndex index{uint16_t(segment << 9)};
+		const ChunkIndex end{uint16_t((segment + 1) << 9)};
+		if (chunk.part8Occupancy(index) == Occupancy::AIR) continue;
+
+		while (index != end) {
+			// Skip parts without any voxels at their first voxel
+			if ((index.mIndex & 0x3F) == 0 && chunk.part4Occupancy(index) == Occupancy::AIR) {
+				index.plusPart4();
+				continue;
+			}
+			if ((index.mIndex & 0x07) == 0 && chunk.part2Occupancy(index) == Occupancy::AIR) {
+				index.plusPart2();
+				continue;
+			}
+
+			Voxel v = chunk.getVoxel(index);
+
+			if (v.mType == VOXEL_AIR) {
+				index++;
+				continue;
+			}
+
+			if (mode == MeshingMode::CULLED) {
+				const vec3i position = index.position();
+				for (size_t face = 0; face < NUM_CUBE_FACES; face++) {
+					if (!faceVisible(chunk, neighbours, face, position)) continue;
+					addQuad(face, position, vec3i{1, 1, 1}, v);
+				}
+			}
+
+			mNumVoxels += 1;
+			index++;
+		}
+
+		if (mode == MeshingMode::GREEDY) {
+			addGreedyQuads(chunk, neighbours, segmentMin(segment));
+		}
+
+		mSegments.numFaces[segment] = mNumFaces - mSegments.begin[segment];
+		mSegments.numVoxels[segment] = mNumVoxels - numVoxelsBefore;
+	}
+}
+
+size_t ChunkMeshBuilder::segmentOf(const vec3i& voxelOffset) noexcept
+{
+	// Same bit order as the part8 bits of ChunkIndex
+	const int half = (int)SEGMENT_SIZE;
+	return (size_t(voxelOffset[0] >= half) << 2) | (size_t(voxelOffset[1] >= half) << 1) |
+	       size_t(voxelOffset[2] >= half);
+}
+
+vec3i ChunkMeshBuilder::segmentMin(size_t segment) noexcept
+{
+	const int half = (int)SEGMENT_SIZE;
+	return vec3i{int((segment >> 2) & 1) * half, int((segment >> 1) & 1) * half, int(segment & 1) * half};
+}
+
+void ChunkMeshBuilder::fillIndices(uint16_t* indices, size_t numFaces) noexcept
+{
+	sfz_assert_debug(numFaces <= CHUNK_MESH_MAX_NUM_FACES);
+	for (size_t iFace = 0; iFace < numFaces; ++iFace) {
+		size_t arrayPos = iFace * CHUNK_MESH_FACE_INDICES;
+		uint16_t indexOffset = uint16_t(iFace * CHUNK_MESH_FACE_VERTICES);
+		for (size_t iArr = 0; iArr < CHUNK_MESH_FACE_INDICES; ++iArr) {
+			indices[arrayPos + iArr] = indexOffset + FACE_INDICES[iArr];
+		}
+	}
+}
+
+// ChunkMeshBuilder: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkMeshBuilder::addQuad(size_t face, const vec3i& position, const vec3i& size, Voxel voxel) noexcept
+{
+	size_t arrayPos = mNumFaces * CHUNK_MESH_FACE_VERTICES;
+	for (size_t i = 0; i < CHUNK_MESH_FACE_VERTICES; i++) {
+		const vec3i& corner = FACE_VERTICES[face][i];
+		const vec3i cornerPos = position + vec3i{corner[0]*size[0], corner[1]*size[1], corner[2]*size[2]};
+		mVertices[arrayPos + i] = packVertex(cornerPos, face, voxel.mType);
+	}
+	mNumFaces += 1;
+}
+
+void ChunkMeshBuilder::addGreedyQuads(const Chunk& chunk, const Chunk* const neighbours[6],
+                                      const vec3i& regionMin) noexcept
+{
+	// Quads never cross the segment's region, so that segments can be rebuilt independently
+	const int SIZE = (int)SEGMENT_SIZE;
+	uint8_t mask[SEGMENT_SIZE][SEGMENT_SIZE];
+
+	for (size_t face = 0; face < NUM_CUBE_FACES; face++) {
+		// The slices are perpendicular to the face normal, quads grow along axis1 then axis2
+		const size_t axis = face / 2;
+		const size_t axis1 = (axis + 1) % 3;
+		const size_t axis2 = (axis + 2) % 3;
+
+		for (int slice = 0; slice < SIZE; slice++) {
+
+			// Mask of the voxel type of each visible face in the slice, 0 if no face
+			vec3i pos;
+			pos[axis] = regionMin[axis] + slice;
+			for (int i = 0; i < SIZE; i++) {
+				for (int j = 0; j < SIZE; j++) {
+					pos[axis1] = regionMin[axis1] + i;
+					pos[axis2] = regionMin[axis2] + j;
+					Voxel v = chunk.getVoxel(pos);
+					bool visible = v.mType != VOXEL_AIR && faceVisible(chunk, neighbours, face, pos);
+					mask[i][j] = visible ? v.mType : VOXEL_AIR;
+				}
+			}
+
+			// Merge runs of the same type into as large rectangles as possible
+			for (int j = 0; j < SIZE; j++) {
+				for (int i = 0; i < SIZE; i++) {
+					const uint8_t type = mask[i][j];
+					if (type == VOXEL_AIR) continue;
+
+					int width = 1;
+					while (i + width < SIZE && mask[i + width][j] == type) width++;
+
+					int height = 1;
+					while (j + height < SIZE) {
+						bool rowMatches = true;
+						for (int k = i; k < i + width; k++) {
+							if (mask[k][j + height] != type) {
+								rowMatches = false;
+								break;
+							}
+						}
+						if (!rowMatches) break;
+						height++;
+					}
+
+					for (int h = j; h < j + height; h++) {
+						for (int k = i; k < i + width; k++) {
+							mask[k][h] = VOXEL_AIR;
+						}
+					}
+
+					vec3i quadPos, quadSize;
+					quadPos[axis] = regionMin[axis] + slice;
+					quadPos[axis1] = regionMin[axis1] + i;
+					quadPos[axis2] = regionMin[axis2] + j;
+					quadSize[axis] = 1;
+					quadSize[axis1] = width;
+					quadSize[axis2] = height;
+					addQuad(face, quadPos, quadSize, Voxel{type});
+				}
+			}
+		}
+	}
+}
+
+} // namespace vox
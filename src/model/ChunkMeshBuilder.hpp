@@ -0,0 +1,124 @@
+#pragma once
+#ifndef VOX_MODEL_CHUNK_MESH_BUILDER_HPP
+#define VOX_MODEL_CHUNK_MESH_BUILDER_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint16_t, uint32_t
+#include <memory>
+
+#include <sfz/math/Vector.hpp>
+
+#include "model/Chunk.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint16_t;
+using std::uint32_t;
+using std::unique_ptr;
+using sfz::vec3i;
+
+// MeshingMode enum
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+enum class MeshingMode {
+	CULLED, // One quad per visible voxel face
+	GREEDY // Adjacent coplanar visible faces of the same voxel type are merged into larger quads
+};
+
+// Chunk mesh constants
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+const size_t CHUNK_MESH_FACE_VERTICES = 4;
+const size_t CHUNK_MESH_FACE_INDICES = 6;
+
+// Upper bound of the number of faces in a chunk mesh. A face requires a solid voxel next to air, so
+// there can be at most one per pair of adjacent voxels inside the chunk plus one per border face.
+const size_t CHUNK_MESH_MAX_NUM_FACES = 3*(CHUNK_SIZE - 1)*CHUNK_SIZE*CHUNK_SIZE + 6*CHUNK_SIZE*CHUNK_SIZE;
+const size_t CHUNK_MESH_MAX_NUM_VERTICES = CHUNK_MESH_MAX_NUM_FACES * CHUNK_MESH_FACE_VERTICES;
+const size_t CHUNK_MESH_MAX_NUM_INDICES = CHUNK_MESH_MAX_NUM_FACES * CHUNK_MESH_FACE_INDICES;
+
+// A mesh is split in one segment per ChunkPart8, segments can be rebuilt and uploaded separately
+const size_t CHUNK_MESH_NUM_SEGMENTS = 8;
+const uint8_t CHUNK_MESH_ALL_SEGMENTS = 0xFF;
+
+/** @brief The faces of each segment in a vertex array, begin and numFaces count faces. */
+struct ChunkMeshSegments final {
+	size_t begin[CHUNK_MESH_NUM_SEGMENTS];
+	size_t numFaces[CHUNK_MESH_NUM_SEGMENTS];
+	size_t numVoxels[CHUNK_MESH_NUM_SEGMENTS];
+};
+
+// ChunkMeshBuilder
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief Builds the vertices of a chunk mesh on the CPU, does not use OpenGL or Assets.
+ * The result is 4 packed vertices (see ChunkMesh for the layout) per face. All faces use the same
+ * index pattern, so the indices only depend on the number of faces and are shared by all meshes.
+ * A builder can be reused, but only by one thread at a time.
+ */
+class ChunkMeshBuilder final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkMeshBuilder(const ChunkMeshBuilder&) = delete;
+	ChunkMeshBuilder& operator= (const ChunkMeshBuilder&) = delete;
+
+	ChunkMeshBuilder() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/**
+	 * @brief Builds the mesh of a chunk, only faces whose neighbouring voxel is air are included.
+	 * The faces are stored segment by segment, see segments().
+	 * @param neighbours the neighbouring chunks in the order -x, +x, -y, +y, -z, +z, may be nullptr.
+	 *                   Missing neighbours are treated as air.
+	 * @param segmentMask bit i set if segment i should be built, other segments are left empty
+	 */
+	void build(const Chunk& chunk, const Chunk* const neighbours[6] = nullptr,
+	           MeshingMode mode = MeshingMode::CULLED,
+	           uint8_t segmentMask = CHUNK_MESH_ALL_SEGMENTS) noexcept;
+
+	/** @brief Returns the segment the voxel at the specified offset inside a chunk belongs to. */
+	static size_t segmentOf(const vec3i& voxelOffset) noexcept;
+
+	/** @brief Returns the offset of the first voxel of the specified segment inside a chunk. */
+	static vec3i segmentMin(size_t segment) noexcept;
+
+	/** @brief Writes the indices of numFaces faces (CHUNK_MESH_FACE_INDICES per face). */
+	static void fillIndices(uint16_t* indices, size_t numFaces) noexcept;
+
+	// Getters
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	inline const uint32_t* vertices() const noexcept { return mVertices.get(); }
+	inline size_t numVoxels() const noexcept { return mNumVoxels; }
+	inline size_t numFaces() const noexcept { return mNumFaces; }
+	inline size_t numVertices() const noexcept { return mNumFaces * CHUNK_MESH_FACE_VERTICES; }
+	inline size_t vertexDataSize() const noexcept { return numVertices() * sizeof(uint32_t); }
+	inline const ChunkMeshSegments& segments() const noexcept { return mSegments; }
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void addQuad(size_t face, const vec3i& position, const vec3i& size, Voxel voxel) noexcept;
+	void addGreedyQuads(const Chunk& chunk, const Chunk* const neighbours[6],
+	                    const vec3i& regionMin) noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	size_t mNumVoxels = 0, mNumFaces = 0;
+	ChunkMeshSegments mSegments;
+	const unique_ptr<uint32_t[]> mVertices;
+};
+
+} // namespace vox
+
+#endif
@@ -0,0 +1,126 @@
+#include "model/ChunkMesher.hpp"
+
+#include <iterator> // std::make_move_iterator
+#include <utility> // std::move
+
+
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+size_t defaultNumThreads() noexcept
+{
+	// Leave one hardware thread for the main (render) thread
+	size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+}
+
+} // anonymous namespace
+
+// ChunkMesher: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+ChunkMesher::ChunkMesher(size_t numThreads) noexcept
+{
+	if (numThreads == 0) numThreads = defaultNumThreads();
+	for (size_t i = 0; i < numThreads; i++) {
+		mThreads.emplace_back(&ChunkMesher::workerLoop, this);
+	}
+}
+
+ChunkMesher::~ChunkMesher() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	for (std::thread& thread : mThreads) {
+		thread.join();
+	}
+}
+
+// ChunkMesher: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkMesher::request(const MeshJob& job) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		auto queued = mQueuedJobs.find(job.index);
+		if (queued != mQueuedJobs.end()) {
+			uint8_t segmentMask = queued->second.segmentMask | job.segmentMask;
+			queued->second = job;
+			queued->second.segmentMask = segmentMask;
+			return;
+		}
+		mQueuedJobs.emplace(job.index, job);
+		mQueue.push_back(job.index);
+	}
+	mCondition.notify_one();
+}
+
+size_t ChunkMesher::takeFinished(vector<MeshedChunk>& out, size_t maxNumMeshes) noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	size_t numTaken = mFinished.size();
+	if (maxNumMeshes != 0 && maxNumMeshes < numTaken) numTaken = maxNumMeshes;
+	out.insert(out.end(), std::make_move_iterator(mFinished.begin()),
+	           std::make_move_iterator(mFinished.begin() + numTaken));
+	mFinished.erase(mFinished.begin(), mFinished.begin() + numTaken);
+	return numTaken;
+}
+
+size_t ChunkMesher::numPending() const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	return mQueue.size() + mNumInProgress + mFinished.size();
+}
+
+// ChunkMesher: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkMesher::workerLoop() noexcept
+{
+	ChunkMeshBuilder builder;
+	MeshJob job;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock{mMutex};
+			mCondition.wait(lock, [this]() { return !mRunning || !mQueue.empty(); });
+			if (!mRunning) return;
+
+			auto queued = mQueuedJobs.find(mQueue.front());
+			job = std::move(queued->second);
+			mQueuedJobs.erase(queued);
+			mQueue.pop_front();
+			mNumInProgress++;
+		}
+
+		const Chunk* neighbours[6];
+		for (size_t dir = 0; dir < 6; dir++) neighbours[dir] = job.neighbours[dir].get();
+		builder.build(*job.chunk, neighbours, job.mode, job.segmentMask);
+
+		MeshedChunk meshed;
+		meshed.index = job.index;
+		meshed.version = job.version;
+		meshed.segmentMask = job.segmentMask;
+		meshed.segments = builder.segments();
+		meshed.vertices.assign(builder.vertices(), builder.vertices() + builder.numVertices());
+
+		// The snapshots are released before the next job is waited for
+		job = MeshJob{};
+		{
+			std::lock_guard<std::mutex> lock{mMutex};
+			mFinished.push_back(std::move(meshed));
+			mNumInProgress--;
+		}
+	}
+}
+
+} // namespace vox
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef VOX_MODEL_CHUNK_MESHER_HPP
+#define VOX_MODEL_CHUNK_MESHER_HPP
+
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "model/Chunk.hpp"
+#include "model/ChunkMeshBuilder.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint32_t;
+using std::shared_ptr;
+using std::vector;
+
+// MeshJob & MeshedChunk
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief Everything needed to mesh a chunk. The chunks are immutable snapshots, so workers never
+ * touch World's chunks, and jobs of neighbouring chunks share them instead of copying.
+ */
+struct MeshJob final {
+	size_t index; // Chunk slot in World
+	uint32_t version; // Used by World to discard results that have been superseded
+	MeshingMode mode;
+	uint8_t segmentMask; // The segments of the mesh to build
+	shared_ptr<const Chunk> chunk;
+	shared_ptr<const Chunk> neighbours[6]; // Order -x, +x, -y, +y, -z, +z, nullptr is air
+};
+
+struct MeshedChunk final {
+	size_t index;
+	uint32_t version;
+	uint8_t segmentMask;
+	ChunkMeshSegments segments; // Where in vertices each built segment is
+	vector<uint32_t> vertices;
+};
+
+// ChunkMesher
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief Pool of worker threads that build chunk meshes on the CPU.
+ *
+ * Jobs are handled in the order they are requested. Requesting a slot that already has a queued
+ * job merges the two into one job, with the newer job's data and version and the segments of both.
+ * Finished vertex data is staged inside the mesher until the owner takes it and uploads it on the
+ * GL thread.
+ */
+class ChunkMesher final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkMesher(const ChunkMesher&) = delete;
+	ChunkMesher& operator= (const ChunkMesher&) = delete;
+
+	/** @param numThreads number of worker threads, 0 to select based on hardware */
+	ChunkMesher(size_t numThreads = 0) noexcept;
+	~ChunkMesher() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void request(const MeshJob& job) noexcept;
+
+	/**
+	 * @brief Moves finished meshes to the end of the out vector, returns number moved.
+	 * @param maxNumMeshes the maximum number of meshes to move, 0 for all
+	 */
+	size_t takeFinished(vector<MeshedChunk>& out, size_t maxNumMeshes = 0) noexcept;
+
+	/** @brief Returns number of requested meshes not yet taken (queued, in progress or finished). */
+	size_t numPending() const noexcept;
+
+	inline size_t numThreads() const noexcept { return mThreads.size(); }
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void workerLoop() noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mRunning = true;
+
+	std::deque<size_t> mQueue; // Chunk slots in request order
+	std::unordered_map<size_t, MeshJob> mQueuedJobs; // The queued job of each slot in mQueue
+	size_t mNumInProgress = 0;
+	std::deque<MeshedChunk> mFinished;
+
+	vector<std::thread> mThreads;
+};
+
+} // namespace vox
+
+#endif
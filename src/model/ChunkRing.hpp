@@ -0,0 +1,40 @@
+#pragma once
+#ifndef VOX_MODEL_CHUNK_RING_HPP
+#define VOX_MODEL_CHUNK_RING_HPP
+
+#include <cstddef> // size_t
+
+#include <sfz/Math.hpp>
+
+
+
+namespace vox {
+
+using std::size_t;
+using sfz::vec3i;
+
+// ChunkRing
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief Toroidal (wrap-around) addressing of chunk slots.
+ *
+ * Each chunk offset maps to the slot given by the offset modulo the extent (2*range+1) of the
+ * loaded region on each axis. Any region of that extent therefore covers every slot exactly once,
+ * and when the region moves only the slots of the slab that scrolled out need to be replaced.
+ */
+struct ChunkRing final {
+	vec3i mExtent;
+
+	ChunkRing() = delete;
+	inline ChunkRing(int horizontalRange, int verticalRange) noexcept;
+
+	inline size_t numSlots() const noexcept;
+	inline size_t slot(const vec3i& offset) const noexcept;
+};
+
+} // namespace vox
+
+
+#include "model/ChunkRing.inl"
+#endif
@@ -0,0 +1,44 @@
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+inline int positiveModulo(int value, int modulus) noexcept
+{
+	int result = value % modulus;
+	return result < 0 ? result + modulus : result;
+}
+
+} // anonymous namespace
+
+// ChunkRing: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline ChunkRing::ChunkRing(int horizontalRange, int verticalRange) noexcept
+:
+	mExtent{horizontalRange*2 + 1, verticalRange*2 + 1, horizontalRange*2 + 1}
+{
+	sfz_assert_debug(horizontalRange >= 0);
+	sfz_assert_debug(verticalRange >= 0);
+}
+
+// ChunkRing: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline size_t ChunkRing::numSlots() const noexcept
+{
+	return size_t(mExtent[0]) * size_t(mExtent[1]) * size_t(mExtent[2]);
+}
+
+inline size_t ChunkRing::slot(const vec3i& offset) const noexcept
+{
+	size_t x = size_t(positiveModulo(offset[0], mExtent[0]));
+	size_t y = size_t(positiveModulo(offset[1], mExtent[1]));
+	size_t z = size_t(positiveModulo(offset[2], mExtent[2]));
+	return (x*size_t(mExtent[1]) + y)*size_t(mExtent[2]) + z;
+}
+
+} // namespace vox
@@ -0,0 +1,170 @@
+#include "model/ChunkWriter.hpp"
+
+#include <utility> // std::swap
+
+
+
+namespace vox {
+
+using std::chrono::steady_clock;
+
+// ChunkWriter: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+ChunkWriter::ChunkWriter(ChunkStorage& storage, const TerrainSettings& terrain,
+                         uint32_t windowMs) noexcept
+:
+	mStorage(storage),
+	mGenerator{createTerrainGenerator(terrain)},
+	mWindow{windowMs}
+{
+	mThread = std::thread{&ChunkWriter::ioLoop, this};
+}
+
+ChunkWriter::~ChunkWriter() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	mThread.join();
+}
+
+// ChunkWriter: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkWriter::write(const vec3i& offset, const Chunk& chunk) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		size_t i = findPending(offset);
+		if (i == mPending.size()) {
+			mPending.push_back(PendingWrite{offset, chunk, 0, steady_clock::now() + mWindow});
+		} else {
+			// Coalesced, the window still ends when it would have for the first write
+			mPending[i].chunk = chunk;
+		}
+		mPending[i].version = ++mLatestVersion;
+	}
+	mCondition.notify_one();
+}
+
+void ChunkWriter::unload(const vec3i& offset) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{mMutex};
+		size_t i = findPending(offset);
+		if (i == mPending.size()) return;
+		mPending[i].due = steady_clock::now();
+	}
+	mCondition.notify_one();
+}
+
+bool ChunkWriter::flush() noexcept
+{
+	std::unique_lock<std::mutex> lock{mMutex};
+	const uint64_t flushNumber = ++mNumFlushesRequested;
+	mCondition.notify_one();
+	mFlushCondition.wait(lock, [&]() { return mNumFlushesDone >= flushNumber; });
+	return mLastFlushSucceeded;
+}
+
+bool ChunkWriter::pendingChunk(const vec3i& offset, Chunk& out) const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	size_t i = findPending(offset);
+	if (i == mPending.size()) return false;
+	out = mPending[i].chunk;
+	return true;
+}
+
+size_t ChunkWriter::numPending() const noexcept
+{
+	std::lock_guard<std::mutex> lock{mMutex};
+	return mPending.size();
+}
+
+// ChunkWriter: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void ChunkWriter::ioLoop() noexcept
+{
+	std::unique_lock<std::mutex> lock{mMutex};
+	while (true) {
+		// Flushes and shutdown write every chunk pending when they start once, even if it fails
+		if (!mRunning || mNumFlushesDone != mNumFlushesRequested) {
+			const bool running = mRunning;
+			const uint64_t numFlushesRequested = mNumFlushesRequested;
+			const bool success = writeBatch(true, lock);
+			mNumFlushesDone = numFlushesRequested;
+			mLastFlushSucceeded = success;
+			mFlushCondition.notify_all();
+			if (!running) return;
+			continue;
+		}
+
+		const steady_clock::time_point now = steady_clock::now();
+		bool anyDue = false;
+		steady_clock::time_point nextDue = now + mWindow;
+		for (const PendingWrite& pending : mPending) {
+			if (pending.due <= now) {
+				anyDue = true;
+				break;
+			}
+			if (pending.due < nextDue) nextDue = pending.due;
+		}
+
+		if (anyDue) {
+			writeBatch(false, lock);
+		} else if (mPending.empty()) {
+			mCondition.wait(lock);
+		} else {
+			mCondition.wait_until(lock, nextDue);
+		}
+	}
+}
+
+bool ChunkWriter::writeBatch(bool all, std::unique_lock<std::mutex>& lock) noexcept
+{
+	const steady_clock::time_point now = steady_clock::now();
+	mBatch.clear();
+	for (const PendingWrite& pending : mPending) {
+		if (all || pending.due <= now) mBatch.push_back(pending);
+	}
+	if (mBatch.empty()) return true;
+
+	// One journal frame and sync for the whole batch
+	lock.unlock();
+	mEncoded.resize(mBatch.size());
+	for (size_t i = 0; i < mBatch.size(); i++) {
+		mGenerated = mGenerator->generateChunk(mBatch[i].offset);
+		mEncoded[i].offset = mBatch[i].offset;
+		mEncoded[i].size = encodeChunk(mBatch[i].chunk, mGenerated, mEncoded[i].data);
+	}
+	const bool success = mStorage.writeChunks(mEncoded.data(), mEncoded.size());
+	lock.lock();
+
+	// Only the I/O thread removes chunks, so the batch is still pending. Chunks written again in
+	// the meantime stay pending with their newer data.
+	for (const PendingWrite& written : mBatch) {
+		size_t i = findPending(written.offset);
+		if (!success) {
+			mPending[i].due = steady_clock::now() + mWindow;
+		} else if (mPending[i].version == written.version) {
+			std::swap(mPending[i], mPending.back());
+			mPending.pop_back();
+		}
+	}
+	return success;
+}
+
+size_t ChunkWriter::findPending(const vec3i& offset) const noexcept
+{
+	for (size_t i = 0; i < mPending.size(); i++) {
+		if (mPending[i].offset == offset) return i;
+	}
+	return mPending.size();
+}
+
+} // namespace vox
@@ -0,0 +1,127 @@
+#pragma once
+#ifndef VOX_MODEL_CHUNK_WRITER_HPP
+#define VOX_MODEL_CHUNK_WRITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sfz/Math.hpp>
+
+#include "model/Chunk.hpp"
+#include "model/TerrainGenerator.hpp"
+#include "io/ChunkIO.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::unique_ptr;
+using std::vector;
+using sfz::vec3i;
+
+// PendingWrite
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+struct PendingWrite final {
+	vec3i offset;
+	Chunk chunk;
+	uint32_t version; // Bumped by every write() of the chunk, only the written version is removed
+	std::chrono::steady_clock::time_point due; // End of the coalescing window
+};
+
+// ChunkWriter
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+/**
+ * @brief I/O thread that writes modified chunks to storage behind the owner's back.
+ *
+ * A written chunk stays pending for a coalescing window, further writes of the same chunk within
+ * the window replace its data instead of writing it again. Pending chunks are written when their
+ * window ends, when they are unloaded, on flush() and on destruction, all chunks due at the same
+ * time as one batch. Failed writes stay pending and are retried after another window.
+ */
+class ChunkWriter final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkWriter() = delete;
+	ChunkWriter(const ChunkWriter&) = delete;
+	ChunkWriter& operator= (const ChunkWriter&) = delete;
+
+	/**
+	 * @param storage the stored chunks of the world, must outlive the writer
+	 * @param terrain the generator chunks are stored as deltas against
+	 * @param windowMs the coalescing window in milliseconds
+	 */
+	ChunkWriter(ChunkStorage& storage, const TerrainSettings& terrain,
+	            uint32_t windowMs = 1000) noexcept;
+
+	/** @brief Writes all pending chunks before returning. */
+	~ChunkWriter() noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/** @brief Queues a copy of the chunk, replacing the chunk's pending data if it has any. */
+	void write(const vec3i& offset, const Chunk& chunk) noexcept;
+
+	/** @brief Ends the coalescing window of the chunk (if pending), it is no longer being edited. */
+	void unload(const vec3i& offset) noexcept;
+
+	/**
+	 * @brief Blocks until every chunk pending when called has been written.
+	 * @return false if any write failed, those chunks stay pending
+	 */
+	bool flush() noexcept;
+
+	/** @brief Copies the pending data of the chunk to out, loads must prefer it over storage. */
+	bool pendingChunk(const vec3i& offset, Chunk& out) const noexcept;
+
+	/** @brief Returns number of modified chunks not yet written (queued or being written). */
+	size_t numPending() const noexcept;
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	void ioLoop() noexcept;
+	bool writeBatch(bool all, std::unique_lock<std::mutex>& lock) noexcept; // Else only due chunks
+	size_t findPending(const vec3i& offset) const noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	ChunkStorage& mStorage;
+	const unique_ptr<TerrainGenerator> mGenerator;
+	const std::chrono::milliseconds mWindow;
+	// Only used by the I/O thread
+	vector<PendingWrite> mBatch;
+	vector<EncodedChunk> mEncoded;
+	Chunk mGenerated;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition; // Wakes the I/O thread
+	std::condition_variable mFlushCondition; // Wakes threads waiting in flush()
+	bool mRunning = true;
+
+	vector<PendingWrite> mPending;
+	uint32_t mLatestVersion = 0;
+	uint64_t mNumFlushesRequested = 0, mNumFlushesDone = 0;
+	bool mLastFlushSucceeded = true;
+
+	std::thread mThread;
+};
+
+} // namespace vox
+
+#endif
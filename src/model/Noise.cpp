@@ -0,0 +1,321 @@
+#include "model/Noise.hpp"
+
+#include <cstdint> // int32_t
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VOX_NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+
+namespace vox {
+
+using std::int32_t;
+
+// Scalar kernels
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+const uint32_t HASH_X = 0x8DA6B343u;
+const uint32_t HASH_Y = 0xCB1AB31Fu;
+const uint32_t HASH_Z = 0xD8163841u;
+const uint32_t OCTAVE_SEED_STEP = 0x9E3779B9u;
+
+// Maps the top 24 bits of a hash, which are exactly representable as a float, to [-1, 1]
+const float LATTICE_SCALE = 2.0f / 16777215.0f;
+
+// Everything about an octave that doesn't depend on the position
+struct Octave final {
+	uint32_t seed;
+	int32_t log2Period;
+	int32_t mask; // period - 1
+	float invPeriod;
+	float amplitude;
+};
+
+inline Octave octave(const FractalNoise& noise, uint32_t i) noexcept
+{
+	Octave o;
+	o.seed = noise.seed + i * OCTAVE_SEED_STEP;
+	o.log2Period = int32_t(noise.log2Period - i);
+	o.mask = (int32_t(1) << o.log2Period) - 1;
+	o.invPeriod = 1.0f / float(o.mask + 1);
+	o.amplitude = 1.0f / float(uint32_t(1) << i);
+	return o;
+}
+
+// Scales the sum of the octaves to [-1, 1]
+inline float normalization(const FractalNoise& noise) noexcept
+{
+	float sumAmplitudes = 0.0f;
+	for (uint32_t i = 0; i < noise.numOctaves; i++) {
+		sumAmplitudes += octave(noise, i).amplitude;
+	}
+	return 1.0f / sumAmplitudes;
+}
+
+inline uint32_t finalizeHash(uint32_t h) noexcept
+{
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+	return h;
+}
+
+inline float latticeValue(uint32_t hash) noexcept
+{
+	return float(int32_t(finalizeHash(hash) >> 8)) * LATTICE_SCALE - 1.0f;
+}
+
+inline float smoothstep(float t) noexcept
+{
+	return t * t * (3.0f - 2.0f * t);
+}
+
+inline float lerp(float a, float b, float t) noexcept
+{
+	return a + t * (b - a);
+}
+
+inline float valueNoise2(const Octave& o, int x, int z) noexcept
+{
+	const uint32_t cx = uint32_t(x >> o.log2Period), cz = uint32_t(z >> o.log2Period);
+	const float sx = smoothstep(float(x & o.mask) * o.invPeriod);
+	const float sz = smoothstep(float(z & o.mask) * o.invPeriod);
+
+	const uint32_t x0 = o.seed ^ (cx * HASH_X), x1 = o.seed ^ ((cx + 1) * HASH_X);
+	const uint32_t z0 = cz * HASH_Z, z1 = (cz + 1) * HASH_Z;
+
+	const float v0 = lerp(latticeValue(x0 ^ z0), latticeValue(x1 ^ z0), sx);
+	const float v1 = lerp(latticeValue(x0 ^ z1), latticeValue(x1 ^ z1), sx);
+	return lerp(v0, v1, sz);
+}
+
+inline float valueNoise3(const Octave& o, int x, int y, int z) noexcept
+{
+	const uint32_t cx = uint32_t(x >> o.log2Period), cy = uint32_t(y >> o.log2Period);
+	const uint32_t cz = uint32_t(z >> o.log2Period);
+	const float sx = smoothstep(float(x & o.mask) * o.invPeriod);
+	const float sy = smoothstep(float(y & o.mask) * o.invPeriod);
+	const float sz = smoothstep(float(z & o.mask) * o.invPeriod);
+
+	const uint32_t x0 = o.seed ^ (cx * HASH_X), x1 = o.seed ^ ((cx + 1) * HASH_X);
+	const uint32_t y0 = cy * HASH_Y, y1 = (cy + 1) * HASH_Y;
+	const uint32_t z0 = cz * HASH_Z, z1 = (cz + 1) * HASH_Z;
+
+	// Named v<y><z>, interpolated along x
+	const float v00 = lerp(latticeValue(x0 ^ y0 ^ z0), latticeValue(x1 ^ y0 ^ z0), sx);
+	const float v10 = lerp(latticeValue(x0 ^ y1 ^ z0), latticeValue(x1 ^ y1 ^ z0), sx);
+	const float v01 = lerp(latticeValue(x0 ^ y0 ^ z1), latticeValue(x1 ^ y0 ^ z1), sx);
+	const float v11 = lerp(latticeValue(x0 ^ y1 ^ z1), latticeValue(x1 ^ y1 ^ z1), sx);
+	return lerp(lerp(v00, v10, sy), lerp(v01, v11, sy), sz);
+}
+
+} // anonymous namespace
+
+// SSE2 kernels
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+#ifdef VOX_NOISE_SSE2
+
+namespace {
+
+// The SIMD kernels perform exactly the same float operations in the same order as the scalar ones,
+// so the results are bitwise identical.
+
+const size_t NUM_VECTORS = NOISE_ROW_SIZE / 4;
+
+// SSE2 has no 32-bit multiply keeping the low bits, even and odd lanes are multiplied separately
+inline __m128i mullo32(__m128i a, __m128i b) noexcept
+{
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+inline __m128i set1(uint32_t value) noexcept
+{
+	return _mm_set1_epi32(int32_t(value));
+}
+
+inline __m128i finalizeHash(__m128i h) noexcept
+{
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+	h = mullo32(h, set1(0x7FEB352Du));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+	h = mullo32(h, set1(0x846CA68Bu));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+	return h;
+}
+
+inline __m128 latticeValue(__m128i hash) noexcept
+{
+	const __m128 value = _mm_cvtepi32_ps(_mm_srli_epi32(finalizeHash(hash), 8));
+	return _mm_sub_ps(_mm_mul_ps(value, _mm_set1_ps(LATTICE_SCALE)), _mm_set1_ps(1.0f));
+}
+
+inline __m128 smoothstep(__m128 t) noexcept
+{
+	const __m128 twoT = _mm_mul_ps(_mm_set1_ps(2.0f), t);
+	return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), twoT));
+}
+
+inline __m128 lerp(__m128 a, __m128 b, __m128 t) noexcept
+{
+	return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+// Lattice cell (times HASH_Z) and interpolation weight along z of 4 consecutive z
+struct ZLanes final {
+	__m128i z0, z1;
+	__m128 sz;
+};
+
+inline ZLanes zLanes(const Octave& o, int z) noexcept
+{
+	const __m128i zs = _mm_add_epi32(_mm_set1_epi32(z), _mm_setr_epi32(0, 1, 2, 3));
+	const __m128i cz = _mm_sra_epi32(zs, _mm_cvtsi32_si128(o.log2Period));
+	const __m128 fz = _mm_cvtepi32_ps(_mm_and_si128(zs, _mm_set1_epi32(o.mask)));
+
+	ZLanes lanes;
+	lanes.z0 = mullo32(cz, set1(HASH_Z));
+	lanes.z1 = mullo32(_mm_add_epi32(cz, _mm_set1_epi32(1)), set1(HASH_Z));
+	lanes.sz = smoothstep(_mm_mul_ps(fz, _mm_set1_ps(o.invPeriod)));
+	return lanes;
+}
+
+void fractalNoise2Sse2(const FractalNoise& noise, int x, int z, float out[NOISE_ROW_SIZE]) noexcept
+{
+	__m128 sums[NUM_VECTORS];
+	for (size_t v = 0; v < NUM_VECTORS; v++) sums[v] = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < noise.numOctaves; i++) {
+		const Octave o = octave(noise, i);
+
+		// x is the same for the whole row
+		const uint32_t cx = uint32_t(x >> o.log2Period);
+		const __m128 sx = _mm_set1_ps(smoothstep(float(x & o.mask) * o.invPeriod));
+		const __m128i x0 = set1(o.seed ^ (cx * HASH_X)), x1 = set1(o.seed ^ ((cx + 1) * HASH_X));
+		const __m128 amplitude = _mm_set1_ps(o.amplitude);
+
+		for (size_t v = 0; v < NUM_VECTORS; v++) {
+			const ZLanes l = zLanes(o, z + int(4 * v));
+			const __m128 v0 = lerp(latticeValue(_mm_xor_si128(x0, l.z0)),
+			                       latticeValue(_mm_xor_si128(x1, l.z0)), sx);
+			const __m128 v1 = lerp(latticeValue(_mm_xor_si128(x0, l.z1)),
+			                       latticeValue(_mm_xor_si128(x1, l.z1)), sx);
+			sums[v] = _mm_add_ps(sums[v], _mm_mul_ps(amplitude, lerp(v0, v1, l.sz)));
+		}
+	}
+
+	const __m128 norm = _mm_set1_ps(normalization(noise));
+	for (size_t v = 0; v < NUM_VECTORS; v++) {
+		_mm_storeu_ps(out + 4 * v, _mm_mul_ps(sums[v], norm));
+	}
+}
+
+void fractalNoise3Sse2(const FractalNoise& noise, int x, int y, int z,
+                       float out[NOISE_ROW_SIZE]) noexcept
+{
+	__m128 sums[NUM_VECTORS];
+	for (size_t v = 0; v < NUM_VECTORS; v++) sums[v] = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < noise.numOctaves; i++) {
+		const Octave o = octave(noise, i);
+
+		// x and y are the same for the whole row
+		const uint32_t cx = uint32_t(x >> o.log2Period), cy = uint32_t(y >> o.log2Period);
+		const __m128 sx = _mm_set1_ps(smoothstep(float(x & o.mask) * o.invPeriod));
+		const __m128 sy = _mm_set1_ps(smoothstep(float(y & o.mask) * o.invPeriod));
+		const uint32_t x0 = o.seed ^ (cx * HASH_X), x1 = o.seed ^ ((cx + 1) * HASH_X);
+		const uint32_t y0 = cy * HASH_Y, y1 = (cy + 1) * HASH_Y;
+		const __m128i x0y0 = set1(x0 ^ y0), x1y0 = set1(x1 ^ y0);
+		const __m128i x0y1 = set1(x0 ^ y1), x1y1 = set1(x1 ^ y1);
+		const __m128 amplitude = _mm_set1_ps(o.amplitude);
+
+		for (size_t v = 0; v < NUM_VECTORS; v++) {
+			const ZLanes l = zLanes(o, z + int(4 * v));
+			const __m128 v00 = lerp(latticeValue(_mm_xor_si128(x0y0, l.z0)),
+			                        latticeValue(_mm_xor_si128(x1y0, l.z0)), sx);
+			const __m128 v10 = lerp(latticeValue(_mm_xor_si128(x0y1, l.z0)),
+			                        latticeValue(_mm_xor_si128(x1y1, l.z0)), sx);
+			const __m128 v01 = lerp(latticeValue(_mm_xor_si128(x0y0, l.z1)),
+			                        latticeValue(_mm_xor_si128(x1y0, l.z1)), sx);
+			const __m128 v11 = lerp(latticeValue(_mm_xor_si128(x0y1, l.z1)),
+			                        latticeValue(_mm_xor_si128(x1y1, l.z1)), sx);
+			const __m128 value = lerp(lerp(v00, v10, sy), lerp(v01, v11, sy), l.sz);
+			sums[v] = _mm_add_ps(sums[v], _mm_mul_ps(amplitude, value));
+		}
+	}
+
+	const __m128 norm = _mm_set1_ps(normalization(noise));
+	for (size_t v = 0; v < NUM_VECTORS; v++) {
+		_mm_storeu_ps(out + 4 * v, _mm_mul_ps(sums[v], norm));
+	}
+}
+
+} // anonymous namespace
+
+#endif
+
+// Noise functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void fractalNoise2(const FractalNoise& noise, int x, int z, float out[NOISE_ROW_SIZE]) noexcept
+{
+#ifdef VOX_NOISE_SSE2
+	fractalNoise2Sse2(noise, x, z, out);
+#else
+	for (size_t i = 0; i < NOISE_ROW_SIZE; i++) {
+		out[i] = fractalNoise2Scalar(noise, x, z + int(i));
+	}
+#endif
+}
+
+void fractalNoise3(const FractalNoise& noise, int x, int y, int z,
+                   float out[NOISE_ROW_SIZE]) noexcept
+{
+#ifdef VOX_NOISE_SSE2
+	fractalNoise3Sse2(noise, x, y, z, out);
+#else
+	for (size_t i = 0; i < NOISE_ROW_SIZE; i++) {
+		out[i] = fractalNoise3Scalar(noise, x, y, z + int(i));
+	}
+#endif
+}
+
+float fractalNoise2Scalar(const FractalNoise& noise, int x, int z) noexcept
+{
+	float sum = 0.0f;
+	for (uint32_t i = 0; i < noise.numOctaves; i++) {
+		const Octave o = octave(noise, i);
+		sum += o.amplitude * valueNoise2(o, x, z);
+	}
+	return sum * normalization(noise);
+}
+
+float fractalNoise3Scalar(const FractalNoise& noise, int x, int y, int z) noexcept
+{
+	float sum = 0.0f;
+	for (uint32_t i = 0; i < noise.numOctaves; i++) {
+		const Octave o = octave(noise, i);
+		sum += o.amplitude * valueNoise3(o, x, y, z);
+	}
+	return sum * normalization(noise);
+}
+
+bool noiseUsesSimd() noexcept
+{
+#ifdef VOX_NOISE_SSE2
+	return true;
+#else
+	return false;
+#endif
+}
+
+} // namespace vox
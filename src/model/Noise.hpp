@@ -0,0 +1,48 @@
+#pragma once
+#ifndef VOX_MODEL_NOISE_HPP
+#define VOX_MODEL_NOISE_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint32_t;
+
+// Number of points evaluated per call by the row functions, the size of a chunk row
+const size_t NOISE_ROW_SIZE = 16;
+
+/**
+ * @brief Seeded fractal value noise, each octave has half the period and amplitude of the one
+ * before it. Periods are powers of two in voxels, so every lattice position and interpolation
+ * weight is computed exactly.
+ */
+struct FractalNoise final {
+	uint32_t seed;
+	uint32_t numOctaves; // At most log2Period + 1
+	uint32_t log2Period; // The period of the first octave is 2^log2Period
+};
+
+/**
+ * @brief Evaluates 2D noise in [-1, 1] at (x, z + i) for i in [0, NOISE_ROW_SIZE).
+ * Uses SSE2 when available, the result is always identical to fractalNoise2Scalar().
+ */
+void fractalNoise2(const FractalNoise& noise, int x, int z, float out[NOISE_ROW_SIZE]) noexcept;
+
+/** @brief Evaluates 3D noise in [-1, 1] at (x, y, z + i) for i in [0, NOISE_ROW_SIZE). */
+void fractalNoise3(const FractalNoise& noise, int x, int y, int z,
+                   float out[NOISE_ROW_SIZE]) noexcept;
+
+/** @brief Scalar reference implementations, one point per call. */
+float fractalNoise2Scalar(const FractalNoise& noise, int x, int z) noexcept;
+float fractalNoise3Scalar(const FractalNoise& noise, int x, int y, int z) noexcept;
+
+/** @brief Whether fractalNoise2() and fractalNoise3() use SIMD kernels in this build. */
+bool noiseUsesSimd() noexcept;
+
+} // namespace vox
+
+#endif
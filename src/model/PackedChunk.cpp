@@ -0,0 +1,176 @@
+#include "model/PackedChunk.hpp"
+
+#include <new> // std::nothrow
+#include <utility> // std::move
+
+
+
+namespace vox {
+
+// Anonymous functions
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+size_t bitsForPaletteSize(size_t paletteSize) noexcept
+{
+	if (paletteSize <= 1) return 0;
+	if (paletteSize <= 2) return 1;
+	if (paletteSize <= 4) return 2;
+	if (paletteSize <= PACKED_CHUNK_MAX_PALETTE_SIZE) return 4;
+	return 8;
+}
+
+inline unique_ptr<uint64_t[]> allocateData(size_t bitsPerVoxel) noexcept
+{
+	return unique_ptr<uint64_t[]>{new (std::nothrow) uint64_t[CHUNK_NUM_VOXELS * bitsPerVoxel / 64]()};
+}
+
+} // anonymous namespace
+
+// PackedChunk: Constructors & destructors
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+PackedChunk::PackedChunk(const Chunk& chunk) noexcept
+{
+	pack(chunk);
+}
+
+// PackedChunk: Public methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void PackedChunk::pack(const Chunk& chunk) noexcept
+{
+	// The palette is sorted by voxel type, values maps each type to its index in the palette
+	bool present[256] = {};
+	for (size_t i = 0; i < CHUNK_NUM_VOXELS; i++) {
+		present[chunk.mVoxels[i].mType] = true;
+	}
+	uint8_t palette[256];
+	uint8_t values[256];
+	size_t paletteSize = 0;
+	for (size_t type = 0; type < 256; type++) {
+		if (!present[type]) continue;
+		palette[paletteSize] = uint8_t(type);
+		values[type] = uint8_t(paletteSize);
+		paletteSize++;
+	}
+
+	const size_t bitsPerVoxel = bitsForPaletteSize(paletteSize);
+	if (bitsPerVoxel == 0) {
+		fill(Voxel{palette[0]});
+		return;
+	}
+	if (bitsPerVoxel == 8) {
+		for (size_t type = 0; type < 256; type++) values[type] = uint8_t(type);
+	} else {
+		for (size_t i = 0; i < paletteSize; i++) mPalette[i] = palette[i];
+		mPaletteSize = uint8_t(paletteSize);
+	}
+
+	if (mBitsPerVoxel != bitsPerVoxel) {
+		mBitsPerVoxel = uint8_t(bitsPerVoxel);
+		mData = allocateData(bitsPerVoxel);
+	}
+	const size_t voxelsPerWord = 64 / bitsPerVoxel;
+	const Voxel* voxel = chunk.mVoxels;
+	for (size_t word = 0; word < CHUNK_NUM_VOXELS / voxelsPerWord; word++) {
+		uint64_t bits = 0;
+		for (size_t i = 0; i < voxelsPerWord; i++) {
+			bits |= uint64_t(values[(voxel++)->mType]) << (i * bitsPerVoxel);
+		}
+		mData[word] = bits;
+	}
+}
+
+void PackedChunk::unpack(Chunk& chunk) const noexcept
+{
+	if (mBitsPerVoxel == 0) {
+		chunk.fill(Voxel{mPalette[0]});
+		return;
+	}
+
+	// With 8 bits per voxel the values are the voxel types themselves
+	uint8_t types[256];
+	for (size_t i = 0; i < 256; i++) {
+		types[i] = mBitsPerVoxel == 8 ? uint8_t(i) : mPalette[i % PACKED_CHUNK_MAX_PALETTE_SIZE];
+	}
+
+	const size_t voxelsPerWord = 64 / mBitsPerVoxel;
+	const uint64_t mask = (uint64_t(1) << mBitsPerVoxel) - 1;
+	Voxel* voxel = chunk.mVoxels;
+	for (size_t word = 0; word < CHUNK_NUM_VOXELS / voxelsPerWord; word++) {
+		uint64_t bits = mData[word];
+		for (size_t i = 0; i < voxelsPerWord; i++) {
+			(voxel++)->mType = types[bits & mask];
+			bits >>= mBitsPerVoxel;
+		}
+	}
+	chunk.updateOccupancy();
+}
+
+bool PackedChunk::partAir(ChunkIndex first, size_t numVoxels) const noexcept
+{
+	sfz_assert_debug(first.mIndex % 64 == 0 && numVoxels % 64 == 0);
+	sfz_assert_debug(first.mIndex + numVoxels <= CHUNK_NUM_VOXELS);
+	const int air = paletteIndex(Voxel{VOXEL_AIR});
+	if (air == -1) return false;
+	if (mBitsPerVoxel == 0) return true;
+
+	// 64 voxels fill whole words, so the part is a run of words that all repeat the air value
+	uint64_t airWord = 0;
+	for (size_t i = 0; i < 64; i += mBitsPerVoxel) airWord |= uint64_t(air) << i;
+	const size_t firstWord = first.mIndex * mBitsPerVoxel / 64;
+	const size_t endWord = firstWord + numVoxels * mBitsPerVoxel / 64;
+	for (size_t word = firstWord; word < endWord; word++) {
+		if (mData[word] != airWord) return false;
+	}
+	return true;
+}
+
+void PackedChunk::fill(Voxel voxel) noexcept
+{
+	mBitsPerVoxel = 0;
+	mPaletteSize = 1;
+	mPalette[0] = voxel.mType;
+	mData.reset();
+}
+
+// PackedChunk: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+size_t PackedChunk::addToPalette(Voxel voxel) noexcept
+{
+	sfz_assert_debug(mBitsPerVoxel != 8);
+	if (mPaletteSize < (size_t(1) << mBitsPerVoxel)) {
+		mPalette[mPaletteSize] = voxel.mType;
+		return mPaletteSize++;
+	}
+
+	const size_t bitsPerVoxel = bitsForPaletteSize(mPaletteSize + 1);
+	repack(bitsPerVoxel);
+	if (bitsPerVoxel == 8) return voxel.mType;
+	mPalette[mPaletteSize] = voxel.mType;
+	return mPaletteSize++;
+}
+
+void PackedChunk::repack(size_t bitsPerVoxel) noexcept
+{
+	// The palette is unchanged, only the values are moved (or replaced by types with 8 bits)
+	unique_ptr<uint64_t[]> data = allocateData(bitsPerVoxel);
+	const size_t voxelsPerWord = 64 / bitsPerVoxel;
+	for (size_t word = 0; word < CHUNK_NUM_VOXELS / voxelsPerWord; word++) {
+		uint64_t bits = 0;
+		for (size_t i = 0; i < voxelsPerWord; i++) {
+			const size_t index = word * voxelsPerWord + i;
+			const uint64_t oldValue = mBitsPerVoxel == 0 ? 0 : rawValue(index);
+			const uint64_t value = bitsPerVoxel == 8 ? mPalette[oldValue] : oldValue;
+			bits |= value << (i * bitsPerVoxel);
+		}
+		data[word] = bits;
+	}
+	mData = std::move(data);
+	mBitsPerVoxel = uint8_t(bitsPerVoxel);
+}
+
+} // namespace vox
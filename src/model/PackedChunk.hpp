@@ -0,0 +1,112 @@
+#pragma once
+#ifndef VOX_MODEL_PACKED_CHUNK_HPP
+#define VOX_MODEL_PACKED_CHUNK_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint64_t
+#include <memory>
+
+#include <sfz/Assert.hpp>
+#include <sfz/Math.hpp>
+
+#include "model/Chunk.hpp"
+#include "model/Voxel.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint8_t;
+using std::uint64_t;
+using std::unique_ptr;
+using sfz::vec3i;
+
+// Largest palette used before falling back to storing voxel types directly with 8 bits per voxel
+const size_t PACKED_CHUNK_MAX_PALETTE_SIZE = 16;
+
+/**
+ * @brief Palette compressed chunk, used to keep many chunks resident in little memory.
+ *
+ * Each voxel is stored as an index into a small palette of the voxel types in the chunk, using 0,
+ * 1, 2 or 4 bits per voxel depending on the number of types. Chunks with more than 16 types store
+ * the types directly with 8 bits per voxel. Uniform chunks (0 bits) have no voxel storage at all.
+ * The voxels are stored in the same (Morton) order as in Chunk, 64 bits per word.
+ *
+ * setVoxel() widens the storage when a voxel type that doesn't fit in the palette is added, it
+ * never narrows it. pack() always selects the smallest width.
+ */
+class PackedChunk final {
+public:
+	// Constructors & destructors
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	PackedChunk(const PackedChunk&) = delete;
+	PackedChunk& operator= (const PackedChunk&) = delete;
+	PackedChunk(PackedChunk&&) noexcept = default;
+	PackedChunk& operator= (PackedChunk&&) noexcept = default;
+
+	/** @brief Creates a uniform chunk of air. */
+	PackedChunk() noexcept = default;
+	explicit PackedChunk(const Chunk& chunk) noexcept;
+
+	// Public methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	/** @brief Replaces the content with the chunk, using as few bits per voxel as possible. */
+	void pack(const Chunk& chunk) noexcept;
+
+	/** @brief Writes all voxels (and the occupancy) to the chunk. */
+	void unpack(Chunk& chunk) const noexcept;
+
+	/** @brief Makes the chunk uniform, freeing the voxel storage. */
+	void fill(Voxel voxel) noexcept;
+
+	inline Voxel getVoxel(ChunkIndex index) const noexcept;
+	inline Voxel getVoxel(size_t x, size_t y, size_t z) const noexcept;
+	inline Voxel getVoxel(const vec3i& offset) const noexcept;
+	inline void setVoxel(ChunkIndex index, Voxel voxel) noexcept;
+	inline void setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept;
+	inline void setVoxel(const vec3i& offset, Voxel voxel) noexcept;
+
+	/**
+	 * @brief Returns whether all voxels of the part starting at first are air, without unpacking.
+	 * @param numVoxels voxels in the part, a multiple of 64 (e.g. 512 for a part8, 64 for a part4)
+	 */
+	bool partAir(ChunkIndex first, size_t numVoxels) const noexcept;
+
+	// Getters
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	inline size_t bitsPerVoxel() const noexcept { return mBitsPerVoxel; }
+	inline size_t paletteSize() const noexcept { return mPaletteSize; }
+	inline bool uniform() const noexcept { return mBitsPerVoxel == 0; }
+
+	/** @brief Size of the voxel storage in bytes, excluding the palette. */
+	inline size_t dataSize() const noexcept { return CHUNK_NUM_VOXELS * mBitsPerVoxel / 8; }
+
+private:
+	// Private methods
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	inline int paletteIndex(Voxel voxel) const noexcept;
+	inline uint64_t rawValue(size_t index) const noexcept;
+	inline void setRawValue(size_t index, uint64_t value) noexcept;
+
+	/** @brief Adds a type to the palette, widening the storage if it is full. Returns its index. */
+	size_t addToPalette(Voxel voxel) noexcept;
+	void repack(size_t bitsPerVoxel) noexcept;
+
+	// Private members
+	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+	uint8_t mBitsPerVoxel = 0; // 0, 1, 2, 4 or 8
+	uint8_t mPaletteSize = 1; // Unused with 8 bits per voxel
+	uint8_t mPalette[PACKED_CHUNK_MAX_PALETTE_SIZE] = {VOXEL_AIR};
+	unique_ptr<uint64_t[]> mData; // nullptr for uniform chunks
+};
+
+} // namespace vox
+
+#include "model/PackedChunk.inl"
+#endif
@@ -0,0 +1,84 @@
+namespace vox {
+
+// PackedChunk: Getters & setters
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+inline Voxel PackedChunk::getVoxel(ChunkIndex index) const noexcept
+{
+	sfz_assert_debug(index.mIndex < ChunkIterateEnd.mIndex);
+	if (mBitsPerVoxel == 0) return Voxel{mPalette[0]};
+	const uint64_t value = rawValue(index.mIndex);
+	if (mBitsPerVoxel == 8) return Voxel{uint8_t(value)};
+	return Voxel{mPalette[value]};
+}
+
+inline Voxel PackedChunk::getVoxel(size_t x, size_t y, size_t z) const noexcept
+{
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	sfz_assert_debug(z < CHUNK_SIZE);
+	return getVoxel(ChunkIndex{chunkVoxelIndex(x, y, z)});
+}
+
+inline Voxel PackedChunk::getVoxel(const vec3i& offset) const noexcept
+{
+	sfz_assert_debug(0 <= offset[0]);
+	sfz_assert_debug(0 <= offset[1]);
+	sfz_assert_debug(0 <= offset[2]);
+	return getVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2]);
+}
+
+inline void PackedChunk::setVoxel(ChunkIndex index, Voxel voxel) noexcept
+{
+	sfz_assert_debug(index.mIndex < ChunkIterateEnd.mIndex);
+	int value = paletteIndex(voxel);
+	if (value == -1) value = (int)addToPalette(voxel);
+	if (mBitsPerVoxel != 0) setRawValue(index.mIndex, (uint64_t)value);
+}
+
+inline void PackedChunk::setVoxel(size_t x, size_t y, size_t z, Voxel voxel) noexcept
+{
+	sfz_assert_debug(x < CHUNK_SIZE);
+	sfz_assert_debug(y < CHUNK_SIZE);
+	sfz_assert_debug(z < CHUNK_SIZE);
+	setVoxel(ChunkIndex{chunkVoxelIndex(x, y, z)}, voxel);
+}
+
+inline void PackedChunk::setVoxel(const vec3i& offset, Voxel voxel) noexcept
+{
+	sfz_assert_debug(0 <= offset[0]);
+	sfz_assert_debug(0 <= offset[1]);
+	sfz_assert_debug(0 <= offset[2]);
+	setVoxel((size_t)offset[0], (size_t)offset[1], (size_t)offset[2], voxel);
+}
+
+// PackedChunk: Private methods
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+// Returns the value stored for the voxel type, -1 if it can't be stored without widening
+inline int PackedChunk::paletteIndex(Voxel voxel) const noexcept
+{
+	if (mBitsPerVoxel == 8) return voxel.mType;
+	for (int i = 0; i < (int)mPaletteSize; i++) {
+		if (mPalette[i] == voxel.mType) return i;
+	}
+	return -1;
+}
+
+// The bits per voxel always divide 64, so a value never straddles two words
+inline uint64_t PackedChunk::rawValue(size_t index) const noexcept
+{
+	const size_t bit = index * mBitsPerVoxel;
+	const uint64_t mask = (uint64_t(1) << mBitsPerVoxel) - 1;
+	return (mData[bit >> 6] >> (bit & 63)) & mask;
+}
+
+inline void PackedChunk::setRawValue(size_t index, uint64_t value) noexcept
+{
+	const size_t bit = index * mBitsPerVoxel;
+	const uint64_t mask = ((uint64_t(1) << mBitsPerVoxel) - 1) << (bit & 63);
+	uint64_t& word = mData[bit >> 6];
+	word = (word & ~mask) | ((value << (bit & 63)) & mask);
+}
+
+} // namespace vox
@@ -2,6 +2,10 @@
 #ifndef VOX_MODEL_TERRAIN_GENERATION_HPP
 #define VOX_MODEL_TERRAIN_GENERATION_HPP
 
+#include <algorithm> // std::max, std::min
+#include <cstdint> // int64_t
+#include <limits>
+
 #include <sfz/Math.hpp>
 
 #include "model/Chunk.hpp"
@@ -11,14 +15,31 @@
 
 namespace vox {
 
+using std::int64_t;
 using sfz::vec3i;
 
+/** @brief The surface heights of a column of chunks, shared by all chunks in the column. */
+struct ChunkHeightmap final {
+	int heights[CHUNK_SIZE][CHUNK_SIZE]; // World y of the surface, indexed [x][z]
+	int minHeight, maxHeight;
+};
+
+/** @brief Generates the chunk at the offset, evaluating the height once per voxel column. */
 inline Chunk generateChunk(const vec3i& offset) noexcept;
 
+/** @brief Generates the chunk with the y offset in the column of chunks the heightmap belongs to. */
+inline Chunk generateChunk(const ChunkHeightmap& heightmap, int chunkY) noexcept;
+
+inline ChunkHeightmap generateHeightmap(int chunkX, int chunkZ) noexcept;
+
+/** @brief World y of the surface at the world x and z. */
+inline int terrainHeight(int x, int z) noexcept;
+
+/** @brief The voxel at the world position, the definition generateChunk() must match. */
 inline Voxel generateVoxel(const vec3i& worldOffset) noexcept;
 
 } // namespace vox
 
 
 #include "model/TerrainGeneration.inl"
-#endif
\ No newline at end of file
+#endif
@@ -1,48 +1,87 @@
-
-
 namespace vox {
 
 inline Chunk generateChunk(const vec3i& offset) noexcept
 {
-	vec3i worldOffset = offset * static_cast<int>(CHUNK_SIZE);
-	vec3i worldOffsetOrig = worldOffset;
-	Chunk chunk;
+	return generateChunk(generateHeightmap(offset[0], offset[2]), offset[1]);
+}
 
-	for (int y = 0; y < (int)CHUNK_SIZE; y++) {
-		for (int z = 0; z < (int)CHUNK_SIZE; z++) {
-			for (int x = 0; x < (int)CHUNK_SIZE; x++) {
+inline Chunk generateChunk(const ChunkHeightmap& heightmap, int chunkY) noexcept
+{
+	const int minY = chunkY * (int)CHUNK_SIZE;
+	const int maxY = minY + (int)CHUNK_SIZE - 1;
+	Chunk chunk; // All air
 
-				chunk.setVoxel((size_t)x,(size_t)y,(size_t)z, generateVoxel(worldOffset));
-				
-				worldOffset[0] += 1;
+	// Ground
+	const bool hasGround = minY <= 0 && 0 <= maxY;
+	if (hasGround) {
+		for (size_t x = 0; x < CHUNK_SIZE; x++) {
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				chunk.mVoxels[chunkVoxelIndex(x, (size_t)-minY, z)] = Voxel{VOXEL_VANILLA};
 			}
-			worldOffset[2] += 1;
-			worldOffset[0] = worldOffsetOrig[0];
 		}
-		worldOffset[1] += 1;
-		worldOffset[2] = worldOffsetOrig[2];
-		worldOffset[0] = worldOffsetOrig[0];
 	}
 
-	//chunk.updateAllFlags();
+	// Chunks entirely above or below the surface never visit their voxels
+	const bool hasSurface = minY <= heightmap.maxHeight && heightmap.minHeight <= maxY;
+	if (hasSurface) {
+		for (size_t x = 0; x < CHUNK_SIZE; x++) {
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				const int height = heightmap.heights[x][z];
+				if (height < minY || maxY < height || height == 0) continue;
+				chunk.mVoxels[chunkVoxelIndex(x, (size_t)(height - minY), z)] = Voxel{VOXEL_BLUE};
+			}
+		}
+	}
 
+	if (hasGround || hasSurface) chunk.updateOccupancy();
 	return chunk;
 }
 
-inline Voxel generateVoxel(const vec3i& worldOffset) noexcept
+inline ChunkHeightmap generateHeightmap(int chunkX, int chunkZ) noexcept
+{
+	const int worldX = chunkX * (int)CHUNK_SIZE;
+	const int worldZ = chunkZ * (int)CHUNK_SIZE;
+	ChunkHeightmap heightmap;
+	heightmap.minHeight = terrainHeight(worldX, worldZ);
+	heightmap.maxHeight = heightmap.minHeight;
+
+	for (int x = 0; x < (int)CHUNK_SIZE; x++) {
+		for (int z = 0; z < (int)CHUNK_SIZE; z++) {
+			const int height = terrainHeight(worldX + x, worldZ + z);
+			heightmap.heights[x][z] = height;
+			if (height < heightmap.minHeight) heightmap.minHeight = height;
+			if (height > heightmap.maxHeight) heightmap.maxHeight = height;
+		}
+	}
+	return heightmap;
+}
+
+// -0.05*(x-10)*(x-20) - 0.05*(z-10)*(z-20) + 4 rounded towards zero, clamped to the range of int.
+// Integer arithmetic is exact, so the height is the same wherever this is inlined and with any
+// floating point flags. The products overflow int once |x| or |z| passes about 46,000, so they are
+// computed in 64 bits. Beyond 2^30 the height is far below the int range anyway, clamping the
+// coordinates there keeps the 64-bit sum from overflowing without changing the result.
+inline int terrainHeight(int x, int z) noexcept
 {
-	auto heightFunc = [](int x, int z) -> int { return -0.05f*(x-10)*(x-20) - 0.05f*(z-10)*(z-20) + 4; };
+	const int64_t LIMIT = int64_t(1) << 30;
+	const int64_t cx = std::max(-LIMIT, std::min(int64_t(x), LIMIT));
+	const int64_t cz = std::max(-LIMIT, std::min(int64_t(z), LIMIT));
+	const int64_t height = (80 - (cx-10)*(cx-20) - (cz-10)*(cz-20)) / 20;
+	const int64_t MIN_HEIGHT = std::numeric_limits<int>::min();
+	const int64_t MAX_HEIGHT = std::numeric_limits<int>::max();
+	return int(std::max(MIN_HEIGHT, std::min(height, MAX_HEIGHT)));
+}
 
+inline Voxel generateVoxel(const vec3i& worldOffset) noexcept
+{
 	// Ground
 	if (worldOffset[1] == 0) return Voxel{VOXEL_VANILLA};
 
-	if (worldOffset[1] == heightFunc(worldOffset[0], worldOffset[2])) {
+	if (worldOffset[1] == terrainHeight(worldOffset[0], worldOffset[2])) {
 		return Voxel{VOXEL_BLUE};
 	}
-	
+
 	return Voxel{VOXEL_AIR};
-	sfz_assert_debug(false);
 }
 
 } // namespace vox
-
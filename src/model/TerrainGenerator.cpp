@@ -0,0 +1,203 @@
+#include "model/TerrainGenerator.hpp"
+
+#include <algorithm> // std::min, std::max
+#include <atomic>
+#include <climits> // INT_MAX, INT_MIN
+#include <cmath> // std::floor
+#include <new> // std::nothrow
+#include <thread>
+#include <vector>
+
+#include "model/Noise.hpp"
+
+
+
+namespace vox {
+
+// Generators
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+namespace {
+
+const float HEIGHT_SCALE = 48.0f; // Surface heights are in about [-HEIGHT_SCALE, HEIGHT_SCALE]
+const int SOIL_DEPTH = 4; // Including the grass
+const float CAVE_THRESHOLD = 0.35f;
+
+class ParaboloidTerrainGenerator final : public TerrainGenerator {
+public:
+	ChunkHeightmap generateHeightmap(int chunkX, int chunkZ) const noexcept override final
+	{
+		return vox::generateHeightmap(chunkX, chunkZ);
+	}
+
+	Chunk generateChunk(const ChunkHeightmap& heightmap,
+	                    const vec3i& offset) const noexcept override final
+	{
+		return vox::generateChunk(heightmap, offset[1]);
+	}
+};
+
+/**
+ * Columns of stone under a few voxels of soil and a grass top, at the height given by 2D noise.
+ * Caves are carved out of the solid voxels where 3D noise exceeds a threshold. Noise is evaluated
+ * NOISE_ROW_SIZE (a chunk row along z) voxels at a time.
+ */
+class NoiseTerrainGenerator final : public TerrainGenerator {
+public:
+	NoiseTerrainGenerator(uint32_t seed, bool caves) noexcept
+	:
+		mHeightNoise{seed, 5, 7},
+		mCaveNoise{seed ^ 0x5BD1E995u, 2, 5},
+		mCaves{caves}
+	{ }
+
+	ChunkHeightmap generateHeightmap(int chunkX, int chunkZ) const noexcept override final
+	{
+		static_assert(NOISE_ROW_SIZE == CHUNK_SIZE, "A noise row is a row of a chunk");
+		const int worldX = chunkX * (int)CHUNK_SIZE;
+		const int worldZ = chunkZ * (int)CHUNK_SIZE;
+		ChunkHeightmap heightmap;
+		heightmap.minHeight = INT_MAX;
+		heightmap.maxHeight = INT_MIN;
+
+		float row[NOISE_ROW_SIZE];
+		for (size_t x = 0; x < CHUNK_SIZE; x++) {
+			fractalNoise2(mHeightNoise, worldX + (int)x, worldZ, row);
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				const int height = (int)std::floor(row[z] * HEIGHT_SCALE);
+				heightmap.heights[x][z] = height;
+				if (height < heightmap.minHeight) heightmap.minHeight = height;
+				if (height > heightmap.maxHeight) heightmap.maxHeight = height;
+			}
+		}
+		return heightmap;
+	}
+
+	Chunk generateChunk(const ChunkHeightmap& heightmap,
+	                    const vec3i& offset) const noexcept override final
+	{
+		const int minY = offset[1] * (int)CHUNK_SIZE;
+		const int maxY = minY + (int)CHUNK_SIZE - 1;
+		Chunk chunk; // All air
+
+		// Entirely above the surface or entirely stone
+		if (heightmap.maxHeight < minY) return chunk;
+		if (!mCaves && maxY <= heightmap.minHeight - SOIL_DEPTH) {
+			chunk.fill(Voxel{VOXEL_VANILLA});
+			return chunk;
+		}
+
+		// Runs of stone, soil and grass from the bottom of each column up to the surface
+		for (size_t x = 0; x < CHUNK_SIZE; x++) {
+			for (size_t z = 0; z < CHUNK_SIZE; z++) {
+				const int height = heightmap.heights[x][z];
+				const int top = height - minY;
+				if (top < 0) continue;
+				const int end = top < (int)CHUNK_SIZE ? top + 1 : (int)CHUNK_SIZE;
+				const int soil = top - SOIL_DEPTH + 1;
+
+				Voxel* column = chunk.mVoxels + (CHUNK_MORTON_X[x] | CHUNK_MORTON_Z[z]);
+				for (int y = 0; y < end; y++) {
+					const uint8_t type = y < top ? VOXEL_YELLOW : VOXEL_GREEN;
+					column[CHUNK_MORTON_Y[y]] = Voxel{y < soil ? VOXEL_VANILLA : type};
+				}
+			}
+		}
+
+		if (mCaves) carveCaves(chunk, heightmap, offset);
+		chunk.updateOccupancy();
+		return chunk;
+	}
+
+private:
+	void carveCaves(Chunk& chunk, const ChunkHeightmap& heightmap,
+	                const vec3i& offset) const noexcept
+	{
+		const vec3i worldOffset = offset * (int)CHUNK_SIZE;
+		float row[NOISE_ROW_SIZE];
+		for (size_t x = 0; x < CHUNK_SIZE; x++) {
+			int rowMaxHeight = heightmap.heights[x][0];
+			for (size_t z = 1; z < CHUNK_SIZE; z++) {
+				if (heightmap.heights[x][z] > rowMaxHeight) rowMaxHeight = heightmap.heights[x][z];
+			}
+			for (size_t y = 0; y < CHUNK_SIZE; y++) {
+				// Rows entirely above the surface have nothing to carve
+				const int worldY = worldOffset[1] + (int)y;
+				if (worldY > rowMaxHeight) break;
+
+				fractalNoise3(mCaveNoise, worldOffset[0] + (int)x, worldY, worldOffset[2], row);
+				Voxel* base = chunk.mVoxels + (CHUNK_MORTON_X[x] | CHUNK_MORTON_Y[y]);
+				for (size_t z = 0; z < CHUNK_SIZE; z++) {
+					if (row[z] > CAVE_THRESHOLD) base[CHUNK_MORTON_Z[z]] = Voxel{VOXEL_AIR};
+				}
+			}
+		}
+	}
+
+	const FractalNoise mHeightNoise, mCaveNoise;
+	const bool mCaves;
+};
+
+} // anonymous namespace
+
+// TerrainGenerator: Batch generation
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+void TerrainGenerator::generateChunks(const vec3i* offsets, Chunk* out, size_t numChunks,
+                                      size_t numThreads) const noexcept
+{
+	// Small enough to balance the load, large enough that columns of chunks share heightmaps
+	const size_t BATCH_SIZE = 16;
+	std::atomic<size_t> nextIndex{0};
+
+	auto worker = [&]() {
+		ChunkHeightmap heightmap;
+		bool hasHeightmap = false;
+		vec3i heightmapOffset;
+		while (true) {
+			const size_t begin = nextIndex.fetch_add(BATCH_SIZE);
+			if (begin >= numChunks) return;
+			const size_t end = std::min(begin + BATCH_SIZE, numChunks);
+
+			for (size_t i = begin; i < end; i++) {
+				const vec3i& o = offsets[i];
+				if (!hasHeightmap || heightmapOffset[0] != o[0] || heightmapOffset[2] != o[2]) {
+					heightmap = generateHeightmap(o[0], o[2]);
+					heightmapOffset = o;
+					hasHeightmap = true;
+				}
+				out[i] = generateChunk(heightmap, o);
+			}
+		}
+	};
+
+	if (numThreads == 0) numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	numThreads = std::min(numThreads, (numChunks + BATCH_SIZE - 1) / BATCH_SIZE);
+
+	// The calling thread is one of the workers
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+// Generator creation
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+unique_ptr<TerrainGenerator> createTerrainGenerator(const TerrainSettings& settings) noexcept
+{
+	switch (settings.type) {
+	case TerrainType::NOISE:
+		return unique_ptr<TerrainGenerator>{
+		       new (std::nothrow) NoiseTerrainGenerator{settings.seed, settings.caves}};
+	case TerrainType::PARABOLOID:
+	default:
+		return unique_ptr<TerrainGenerator>{new (std::nothrow) ParaboloidTerrainGenerator{}};
+	}
+}
+
+} // namespace vox
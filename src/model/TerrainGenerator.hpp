@@ -0,0 +1,72 @@
+#pragma once
+#ifndef VOX_MODEL_TERRAIN_GENERATOR_HPP
+#define VOX_MODEL_TERRAIN_GENERATOR_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t
+#include <memory>
+
+#include <sfz/Math.hpp>
+
+#include "model/Chunk.hpp"
+#include "model/TerrainGeneration.hpp"
+
+
+
+namespace vox {
+
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+using std::unique_ptr;
+using sfz::vec3i;
+
+enum class TerrainType : uint8_t {
+	PARABOLOID = 0, // The original test terrain, see TerrainGeneration.hpp
+	NOISE = 1 // Fractal value noise heightmap, optionally with caves
+};
+
+struct TerrainSettings final {
+	TerrainType type = TerrainType::PARABOLOID;
+	uint32_t seed = 0;
+	bool caves = false;
+};
+
+/**
+ * @brief Generates the chunks that don't exist on disk.
+ *
+ * Generation is deterministic, the same settings always give the same chunks. The methods are
+ * const and thread safe, one generator is shared by all of ChunkLoader's workers.
+ */
+class TerrainGenerator {
+public:
+	virtual ~TerrainGenerator() noexcept = default;
+
+	/** @brief The heightmap of the column of chunks, shared by all chunks in it. */
+	virtual ChunkHeightmap generateHeightmap(int chunkX, int chunkZ) const noexcept = 0;
+
+	/** @brief Generates the chunk at offset, heightmap must belong to the chunk's column. */
+	virtual Chunk generateChunk(const ChunkHeightmap& heightmap,
+	                            const vec3i& offset) const noexcept = 0;
+
+	inline Chunk generateChunk(const vec3i& offset) const noexcept
+	{
+		return generateChunk(generateHeightmap(offset[0], offset[2]), offset);
+	}
+
+	/**
+	 * @brief Generates out[i] for each offsets[i] on threads started for the call, only used by
+	 * the generation benchmark (World generates through ChunkLoader's workers). Threads claim
+	 * batches of offsets from a shared counter until all are taken. The result doesn't depend on
+	 * the number of threads. Consecutive offsets in the same column of chunks share a heightmap.
+	 * @param numThreads number of threads including the caller, 0 to select based on hardware
+	 */
+	void generateChunks(const vec3i* offsets, Chunk* out, size_t numChunks,
+	                    size_t numThreads = 0) const noexcept;
+};
+
+unique_ptr<TerrainGenerator> createTerrainGenerator(const TerrainSettings& settings) noexcept;
+
+} // namespace vox
+
+#endif
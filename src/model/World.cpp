@@ -1,6 +1,9 @@
 #include "model/World.hpp"
 
 #include <new> // std::nothrow
+#include <utility> // std::move
+
+#include <sfz/util/StopWatch.hpp>
 
 
 
@@ -31,31 +34,83 @@ vec3i maxChunkOffset(const World& world) noexcept
 	return world.currentChunkOffset() + range;
 }
 
-bool outside(const vec3i& offset, const vec3i& min, const vec3i& max) noexcept
+inline bool inRange(int value, int min, int max) noexcept
 {
-	return (offset[0] < min[0] || max[0] < offset[0]) ||
-	       (offset[1] < min[1] || max[1] < offset[1]) ||
-	       (offset[2] < min[2] || max[2] < offset[2]);
+	return min <= value && value <= max;
 }
 
-inline vec3i offsetIterateNext(const vec3i& current, const vec3i& min, const vec3i& max) noexcept
+// Same order as the neighbours argument of ChunkMeshBuilder::build()
+const vec3i NEIGHBOUR_DIRECTIONS[] = {
+	vec3i{-1, 0, 0},
+	vec3i{1, 0, 0},
+	vec3i{0, -1, 0},
+	vec3i{0, 1, 0},
+	vec3i{0, 0, -1},
+	vec3i{0, 0, 1}
+};
+
+// Returns the occupancy of the layer of the chunk facing the neighbour in the specified direction.
+// If it contains any non-air voxels the neighbour's mesh depends on this chunk, if it is all solid
+// the neighbour's faces towards this chunk are all hidden.
+Occupancy borderOccupancy(const Chunk& chunk, size_t direction) noexcept
 {
-	vec3i next = current;
-	next[2]++;
-	if (next[2] > max[2]) {
-		next[2] = min[2];
-		next[1]++;
-		if (next[1] > max[1]) {
-			next[1] = min[1];
-			next[0]++;
+	if (chunk.occupancy() != Occupancy::MIXED) return chunk.occupancy();
+	const size_t PART_SIZE = 4;
+	const size_t axis = direction / 2;
+	const size_t layer = (direction % 2) == 0 ? 0 : CHUNK_SIZE - 1;
+
+	// Only the voxels of the 4^3 parts along the border that are neither all air nor all solid
+	bool hasSolid = false, hasAir = false;
+	size_t pos[3];
+	pos[axis] = layer;
+	for (size_t partA = 0; partA < CHUNK_SIZE; partA += PART_SIZE) {
+		for (size_t partB = 0; partB < CHUNK_SIZE; partB += PART_SIZE) {
+			pos[(axis + 1) % 3] = partA;
+			pos[(axis + 2) % 3] = partB;
+			const Occupancy part = chunk.part4Occupancy(ChunkIndex::fromPosition(pos[0], pos[1], pos[2]));
+			if (part == Occupancy::AIR) hasAir = true;
+			else if (part == Occupancy::SOLID) hasSolid = true;
+			else {
+				for (size_t a = partA; a < partA + PART_SIZE; a++) {
+					for (size_t b = partB; b < partB + PART_SIZE; b++) {
+						pos[(axis + 1) % 3] = a;
+						pos[(axis + 2) % 3] = b;
+						if (chunk.getVoxel(pos[0], pos[1], pos[2]).mType != VOXEL_AIR) hasSolid = true;
+						else hasAir = true;
+					}
+				}
+			}
+			if (hasSolid && hasAir) return Occupancy::MIXED;
 		}
 	}
-	return next;
+	return hasSolid ? Occupancy::SOLID : Occupancy::AIR;
 }
 
-inline vec3i offsetIterateEnd(const vec3i& min, const vec3i& max) noexcept
+// A world is always generated with the terrain settings it was created with, since the chunks that
+// were never modified aren't stored
+TerrainSettings worldTerrainSettings(const std::string& name, const TerrainSettings& settings) noexcept
 {
-	return vec3i{max[0] + 1, min[1], min[2]};
+	TerrainSettings stored;
+	if (readTerrainSettings(stored, name)) {
+		if (stored.type != settings.type || stored.seed != settings.seed ||
+		    stored.caves != settings.caves) {
+			std::cout << "World \"" << name << "\" keeps the terrain settings it was created with."
+			          << std::endl;
+		}
+		return stored;
+	}
+
+	// Worlds from before terrain.bin could only have been generated as paraboloids, their unsaved
+	// chunks (uniform ones were never written) must be generated the same way
+	TerrainSettings created = settings;
+	if (hasStoredChunks(name)) {
+		created = TerrainSettings{};
+		created.type = TerrainType::PARABOLOID;
+		std::cout << "World \"" << name << "\" has no terrain settings, using the paraboloid terrain "
+		          << "it was created with." << std::endl;
+	}
+	writeTerrainSettings(created, name);
+	return created;
 }
 
 } // namespace
@@ -63,42 +118,69 @@ inline vec3i offsetIterateEnd(const vec3i& min, const vec3i& max) noexcept
 // Constructors & destructors
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-World::World(const std::string& name, const vec3& camPos,
-             size_t horizontalRange, size_t verticalRange) noexcept
+World::World(const std::string& name, const vec3& camPos, size_t horizontalRange,
+             size_t verticalRange, const TerrainSettings& terrain) noexcept
 :
 	mHorizontalRange{static_cast<int>(horizontalRange)},
 	mVerticalRange{static_cast<int>(verticalRange)},
 	mNumChunks{calculateNumChunks(mHorizontalRange, mVerticalRange)},
 	mName(name),
-	mChunks{new (std::nothrow) Chunk[mNumChunks]},
-	mChunkMeshes{new (std::nothrow) ChunkMesh[mNumChunks]},
+	mRing{mHorizontalRange, mVerticalRange},
+	mChunks{new (std::nothrow) PackedChunk[mNumChunks]},
+	mNonAirBorders{new (std::nothrow) uint8_t[mNumChunks]},
+	mSolidBorders{new (std::nothrow) uint8_t[mNumChunks]},
+	mChunkMeshes{new (std::nothrow) unique_ptr<ChunkMesh>[mNumChunks]},
 	mOffsets{new (std::nothrow) vec3i[mNumChunks]},
 	mAvailabilities{new (std::nothrow) bool[mNumChunks]},
-	mToBeReplaced{new (std::nothrow) bool[mNumChunks]}
+	mTerrain{worldTerrainSettings(name, terrain)},
+	mStorage{name},
+	mWriter{mStorage, mTerrain},
+	mLoader{mStorage, mWriter, mTerrain},
+	mSegmentVersions{new (std::nothrow) uint32_t[mNumChunks * CHUNK_MESH_NUM_SEGMENTS]},
+	mDirtySegments{new (std::nothrow) uint8_t[mNumChunks]},
+	mSnapshots{new (std::nothrow) shared_ptr<const Chunk>[mNumChunks]}
 {
+	sfz_assert_debug(mRing.numSlots() == mNumChunks);
+	// Before the first chunk is requested from the loader
+	mStorage.recoverJournal();
+	mStorage.convertChunkFiles();
 	mCurrentChunkOffset = chunkOffsetFromPosition(camPos);
 
 	for (size_t i = 0; i < mNumChunks; i++) {
 		mOffsets[i] = vec3i{-100000000, -1000000000, -10000000};
 		mAvailabilities[i] = false;
-		mToBeReplaced[i] = true;
+		mDirtySegments[i] = 0;
+		mNonAirBorders[i] = 0;
+		mSolidBorders[i] = 0;
+	}
+	for (size_t i = 0; i < mNumChunks * CHUNK_MESH_NUM_SEGMENTS; i++) {
+		mSegmentVersions[i] = 0;
 	}
 
-	loadChunks();
+	// Empty old range, i.e. request everything
+	requestChunks(vec3i{1, 1, 1}, vec3i{0, 0, 0});
 }
 
 // Public member functions
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-void World::update(const vec3& camPos) noexcept
+void World::update(const vec3& camPos, size_t maxChunkUploads, float maxStreamingMs) noexcept
 {
+	vec3i oldMin = minChunkOffset(*this);
+	vec3i oldMax = maxChunkOffset(*this);
 	vec3i oldChunkOffset = mCurrentChunkOffset;
 	mCurrentChunkOffset = chunkOffsetFromPosition(camPos);
 
 	if (oldChunkOffset != mCurrentChunkOffset) {
-		checkWhichChunksToReplace();
-		loadChunks();
+		requestChunks(oldMin, oldMax);
 	}
+
+	// All three steps share the frame's budget, whatever is left over is handled on later frames
+	sfz::StopWatch stopWatch;
+	publishLoadedChunks(maxChunkUploads, maxStreamingMs, stopWatch);
+	requestDirtyMeshes(maxChunkUploads, maxStreamingMs, stopWatch);
+	uploadMeshedChunks(maxChunkUploads, maxStreamingMs, stopWatch);
+	mLastStreamingMs = stopWatch.getTimeMilliSeconds();
 }
 
 vec3 World::positionFromChunkOffset(const vec3i& offset) const noexcept
@@ -129,16 +211,30 @@ void World::setVoxel(const vec3i& position, Voxel voxel) noexcept
 
 	int index = chunkIndex(chunkOffset);
 	if (index == -1) return;
-	Chunk* chunkPtr = &mChunks[index];
-	Voxel oldVoxel = chunkPtr->getVoxel(voxelOffset);
-	
-	chunkPtr->setVoxel(voxelOffset, voxel);
-	bool success = writeChunk(*chunkPtr, chunkOffset[0], chunkOffset[1], chunkOffset[2], mName);
-	if (!success) {
-		chunkPtr->setVoxel(voxelOffset, oldVoxel);
-	} else {
-		mChunkMeshes[index].set(*chunkPtr);
+
+	// Edited unpacked and packed once, which also narrows the chunk if a voxel type disappeared
+	mChunks[index].unpack(mEditChunk);
+	mEditChunk.setVoxel(voxelOffset, voxel);
+	mWriter.write(chunkOffset, mEditChunk);
+	setChunk((size_t)index, mEditChunk);
+
+	// Only the mesh segments containing the voxel or one of its neighbours are affected, the
+	// neighbours may be in a neighbouring chunk
+	uint8_t segmentMask = uint8_t(1 << ChunkMeshBuilder::segmentOf(voxelOffset));
+	for (size_t dir = 0; dir < 6; dir++) {
+		vec3i neighbourOffset = voxelOffset + NEIGHBOUR_DIRECTIONS[dir];
+		const size_t axis = dir / 2;
+		if (0 <= neighbourOffset[axis] && neighbourOffset[axis] < (int)CHUNK_SIZE) {
+			segmentMask |= uint8_t(1 << ChunkMeshBuilder::segmentOf(neighbourOffset));
+			continue;
+		}
+		int neighbourIndex = chunkIndex(chunkOffset + NEIGHBOUR_DIRECTIONS[dir]);
+		if (neighbourIndex == -1) continue;
+		neighbourOffset[axis] = (neighbourOffset[axis] + (int)CHUNK_SIZE) % (int)CHUNK_SIZE;
+		markMeshDirty((size_t)neighbourIndex,
+		              uint8_t(1 << ChunkMeshBuilder::segmentOf(neighbourOffset)));
 	}
+	markMeshDirty((size_t)index, segmentMask);
 }
 
 void World::setVoxel(const vec3& position, Voxel voxel) noexcept
@@ -146,33 +242,43 @@ void World::setVoxel(const vec3& position, Voxel voxel) noexcept
 	setVoxel(vec3i{(int)position[0], (int)position[1], (int)position[2]}, voxel);
 }
 
+bool World::flushChunks() noexcept
+{
+	const bool success = mWriter.flush();
+	return mStorage.checkpoint() && success;
+}
+
 // Getters / setters
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-size_t World::chunkIndex(const Chunk* chunkPtr) const noexcept
+void World::meshingMode(MeshingMode mode) noexcept
 {
-	return chunkPtr - (&mChunks[0]);
+	if (mMeshingMode == mode) return;
+	mMeshingMode = mode;
+	for (size_t i = 0; i < mNumChunks; i++) {
+		if (mAvailabilities[i]) markMeshDirty(i);
+	}
 }
 
 int World::chunkIndex(const vec3i& offset) const noexcept
 {
-	for (int i = 0; i < (int)mNumChunks; i++) {
-		if (mOffsets[i] == offset && mAvailabilities[i]) return i;
-	}
-	return -1;
+	size_t index = mRing.slot(offset);
+	if (!mAvailabilities[index] || mOffsets[index] != offset) return -1;
+	return (int)index;
 }
 
 
-const Chunk* World::chunkPtr(size_t index) const noexcept
+const PackedChunk& World::packedChunk(size_t index) const noexcept
 {
 	sfz_assert_debug(index < mNumChunks);
-	return &mChunks[index];
+	return mChunks[index];
 }
 
-const ChunkMesh& World::chunkMesh(size_t index) const noexcept
+
+const ChunkMesh* World::chunkMesh(size_t index) const noexcept
 {
 	sfz_assert_debug(index < mNumChunks);
-	return mChunkMeshes[index];
+	return mChunkMeshes[index].get();
 }
 
 const vec3i World::chunkOffset(size_t index) const noexcept
@@ -194,8 +300,7 @@ Voxel World::getVoxel(const vec3i& offset) const noexcept
 
 	int index = chunkIndex(chunkOffset);
 	if (index == -1) return Voxel{VOXEL_AIR};
-	Chunk* chunkPtr = &mChunks[index];
-	return chunkPtr->getVoxel(voxelOffset);
+	return mChunks[index].getVoxel(voxelOffset);
 }
 
 Voxel World::getVoxel(const vec3& position) const noexcept
@@ -206,54 +311,247 @@ Voxel World::getVoxel(const vec3& position) const noexcept
 // Private methods
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-void World::checkWhichChunksToReplace() noexcept
+void World::requestChunks(const vec3i& oldMin, const vec3i& oldMax) noexcept
 {
 	const vec3i min = minChunkOffset(*this);
 	const vec3i max = maxChunkOffset(*this);
-	for (size_t i = 0; i < mNumChunks; i++) {
-		mToBeReplaced[i] = outside(mOffsets[i], min, max);
+	mLoader.setRange(mCurrentChunkOffset, min, max);
+
+	// Only visits the offsets inside the new range but outside the old one. Each of them maps to a
+	// slot that currently holds a chunk which scrolled out of range.
+	for (int x = min[0]; x <= max[0]; x++) {
+		bool xInOld = inRange(x, oldMin[0], oldMax[0]);
+		for (int y = min[1]; y <= max[1]; y++) {
+			bool xyInOld = xInOld && inRange(y, oldMin[1], oldMax[1]);
+			for (int z = min[2]; z <= max[2]; z++) {
+				if (xyInOld && inRange(z, oldMin[2], oldMax[2])) {
+					z = oldMax[2];
+					continue;
+				}
+
+				const vec3i offset{x, y, z};
+				const size_t index = mRing.slot(offset);
+				if (mOffsets[index] == offset) continue; // Already loaded or requested
+
+				// Slot is unavailable until the loader has delivered the new chunk, the chunk that
+				// scrolled out of range is written without waiting for the rest of its window
+				mWriter.unload(mOffsets[index]);
+				mOffsets[index] = offset;
+				mAvailabilities[index] = false;
+				mLoader.request(offset);
+			}
+		}
 	}
 }
 
-void World::loadChunks() noexcept
+void World::publishLoadedChunks(size_t maxChunks, float maxStreamingMs,
+                                sfz::StopWatch& stopWatch) noexcept
 {
-	const vec3i min = minChunkOffset(*this);
-	const vec3i max = maxChunkOffset(*this);
-	const vec3i end = offsetIterateEnd(min, max);
-	vec3i itr = min;
-	size_t currentWriteIndex = 0;
-	size_t chunksLoaded = 0;
-
-	while (itr != end) {
-		bool offsetIsLoaded = false;
-		for (size_t i = 0; i < mNumChunks; i++) {
-			if (mOffsets[i] == itr && !mToBeReplaced[i]) {
-				offsetIsLoaded = true;
-				break;
-			}
+	size_t numPublished = 0;
+
+	while (maxChunks == 0 || numPublished < maxChunks) {
+		if (maxStreamingMs > 0.0f && stopWatch.getTimeMilliSeconds() >= maxStreamingMs) break;
+
+		mLoadedChunks.clear();
+		if (mLoader.takeFinished(mLoadedChunks, 1) == 0) break;
+		const LoadedChunk& loaded = mLoadedChunks.front();
+
+		// Skip chunks whose slot has been reassigned (or filled) since they were requested
+		const size_t index = mRing.slot(loaded.offset);
+		if (mOffsets[index] != loaded.offset || mAvailabilities[index]) continue;
+
+		setChunk(index, loaded.chunk);
+		mAvailabilities[index] = true;
+		releaseMesh(index); // Still holds the mesh of the slot's previous chunk
+		markMeshDirty(index);
+		numPublished++;
+		if (loaded.generated) mNumChunksGenerated++;
+
+		// Neighbours previously meshed without this chunk might have faces that are now hidden
+		for (size_t dir = 0; dir < 6; dir++) {
+			int neighbourIndex = chunkIndex(loaded.offset + NEIGHBOUR_DIRECTIONS[dir]);
+			if (neighbourIndex == -1 || (mNonAirBorders[index] & (1 << dir)) == 0) continue;
+			markMeshDirty((size_t)neighbourIndex);
+		}
+	}
+}
+
+void World::setChunk(size_t index, const Chunk& chunk) noexcept
+{
+	mChunks[index].pack(chunk);
+	updateBorders(index, chunk);
+}
+
+void World::updateBorders(size_t index, const Chunk& chunk) noexcept
+{
+	mNonAirBorders[index] = 0;
+	mSolidBorders[index] = 0;
+	for (size_t dir = 0; dir < 6; dir++) {
+		const Occupancy border = borderOccupancy(chunk, dir);
+		if (border != Occupancy::AIR) mNonAirBorders[index] |= uint8_t(1 << dir);
+		if (border == Occupancy::SOLID) mSolidBorders[index] |= uint8_t(1 << dir);
+	}
+}
+
+bool World::needsMesh(size_t index) const noexcept
+{
+	// A uniform chunk only has visible faces where a neighbour does not cover its border
+	const PackedChunk& chunk = mChunks[index];
+	if (!chunk.uniform()) return true;
+	if (chunk.getVoxel(ChunkIterateBegin).mType == VOXEL_AIR) return false;
+	for (size_t dir = 0; dir < 6; dir++) {
+		int neighbourIndex = chunkIndex(mOffsets[index] + NEIGHBOUR_DIRECTIONS[dir]);
+		if (neighbourIndex == -1) return true; // Missing neighbours are meshed as air
+		if ((mSolidBorders[neighbourIndex] & (1 << (dir ^ 1))) == 0) return true;
+	}
+	return false;
+}
+
+void World::releaseMesh(size_t index) noexcept
+{
+	if (!mChunkMeshes[index]) return;
+	mChunkMeshes[index]->clear();
+	mFreeMeshes.push_back(std::move(mChunkMeshes[index]));
+}
+
+void World::markMeshDirty(size_t index, uint8_t segmentMask) noexcept
+{
+	if (mDirtySegments[index] == 0) mDirtyMeshes.push_back(index);
+	mDirtySegments[index] |= segmentMask;
+}
+
+void World::requestDirtyMeshes(size_t maxJobs, float maxStreamingMs,
+                               sfz::StopWatch& stopWatch) noexcept
+{
+	// Each chunk is requested at most once per frame, no matter how many times it was modified.
+	// Chunks beyond the budget stay dirty and are requested on later frames.
+	MeshJob job;
+	size_t numRequested = 0;
+	size_t numTaken = 0;
+	for (; numTaken < mDirtyMeshes.size(); numTaken++) {
+		if (maxJobs != 0 && numRequested >= maxJobs) break;
+		if (maxStreamingMs > 0.0f && stopWatch.getTimeMilliSeconds() >= maxStreamingMs) break;
+
+		const size_t index = mDirtyMeshes[numTaken];
+		uint8_t segmentMask = mDirtySegments[index];
+		mDirtySegments[index] = 0;
+		if (!mAvailabilities[index]) continue;
+
+		// Chunks without visible faces are not meshed, all older results for them become stale
+		const bool meshNeeded = needsMesh(index);
+		if (!meshNeeded) segmentMask = CHUNK_MESH_ALL_SEGMENTS;
+
+		mLatestMeshVersion += 1;
+		uint32_t* segmentVersions = &mSegmentVersions[index * CHUNK_MESH_NUM_SEGMENTS];
+		for (size_t i = 0; i < CHUNK_MESH_NUM_SEGMENTS; i++) {
+			if (segmentMask & (1 << i)) segmentVersions[i] = mLatestMeshVersion;
+		}
+		if (!meshNeeded) {
+			releaseMesh(index);
+			continue;
 		}
 
-		if (!offsetIsLoaded) {
-			while (!mToBeReplaced[currentWriteIndex]) currentWriteIndex++;
-			sfz_assert_debug(currentWriteIndex < mNumChunks);
+		job.index = index;
+		job.version = mLatestMeshVersion;
+		job.mode = mMeshingMode;
+		job.segmentMask = segmentMask;
+		job.chunk = snapshot(index);
+		for (size_t dir = 0; dir < 6; dir++) {
+			int neighbourIndex = chunkIndex(mOffsets[index] + NEIGHBOUR_DIRECTIONS[dir]);
+			job.neighbours[dir] = neighbourIndex != -1 ? snapshot(neighbourIndex) : nullptr;
+		}
+		mMesher.request(job);
+		numRequested++;
+	}
+	mDirtyMeshes.erase(mDirtyMeshes.begin(), mDirtyMeshes.begin() + numTaken);
+
+	// The jobs keep their snapshots, later edits need new ones
+	for (size_t index : mSnapshotIndices) mSnapshots[index] = nullptr;
+	mSnapshotIndices.clear();
+}
+
+const shared_ptr<const Chunk>& World::snapshot(size_t index) noexcept
+{
+	if (mSnapshots[index] == nullptr) {
+		shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+		mChunks[index].unpack(*chunk);
+		mSnapshots[index] = std::move(chunk);
+		mSnapshotIndices.push_back(index);
+	}
+	return mSnapshots[index];
+}
 
-			if (!readChunk(mChunks[currentWriteIndex], itr[0], itr[1], itr[2], mName)) {
-				std::cout << "Generated and wrote chunk at: " << mOffsets[currentWriteIndex] << std::endl;
-				mChunks[currentWriteIndex] = generateChunk(itr);
-				writeChunk(mChunks[currentWriteIndex], itr[0], itr[1], itr[2], mName);
+void World::uploadMeshedChunks(size_t maxChunkUploads, float maxStreamingMs,
+                               sfz::StopWatch& stopWatch) noexcept
+{
+	size_t numUploads = 0;
+
+	while (maxChunkUploads == 0 || numUploads < maxChunkUploads) {
+		if (maxStreamingMs > 0.0f && stopWatch.getTimeMilliSeconds() >= maxStreamingMs) break;
+
+		mMeshedChunks.clear();
+		if (mMesher.takeFinished(mMeshedChunks, 1) == 0) break;
+		const MeshedChunk& meshed = mMeshedChunks.front();
+
+		// Skip meshes of chunks that have been unloaded, and segments requested again since. Jobs
+		// can be merged by the mesher, so a newer version than the requested one is also current.
+		if (!mAvailabilities[meshed.index]) continue;
+		uint8_t currentSegments = 0;
+		for (size_t i = 0; i < CHUNK_MESH_NUM_SEGMENTS; i++) {
+			if ((meshed.segmentMask & (1 << i)) == 0) continue;
+			if (meshed.version >= mSegmentVersions[meshed.index * CHUNK_MESH_NUM_SEGMENTS + i]) {
+				currentSegments |= uint8_t(1 << i);
 			}
-			mChunkMeshes[currentWriteIndex].set(mChunks[currentWriteIndex]);
-			mOffsets[currentWriteIndex] = itr;
-			mAvailabilities[currentWriteIndex] = true;
-			mToBeReplaced[currentWriteIndex] = false;
-			chunksLoaded++;
-			currentWriteIndex++;
 		}
+		if (currentSegments == 0) continue;
+
+		// Meshes are only kept for chunks with visible faces, without one all segments are empty
+		unique_ptr<ChunkMesh>& mesh = mChunkMeshes[meshed.index];
+		if (!mesh) {
+			if (meshed.vertices.empty()) continue;
+			if (!mFreeMeshes.empty()) {
+				mesh = std::move(mFreeMeshes.back());
+				mFreeMeshes.pop_back();
+			} else {
+				mesh.reset(new (std::nothrow) ChunkMesh{});
+			}
+		}
+		mesh->upload(meshed.vertices.data(), meshed.segments, currentSegments);
+		if (mesh->numVertices() == 0) releaseMesh(meshed.index);
+		numUploads++;
+	}
 
-		itr = offsetIterateNext(itr, min, max);
+	mLastNumChunkUploads = numUploads;
+	if (!mMeshStatsPrinted && mLoader.numPending() == 0 && numMeshesPending() == 0) {
+		printMeshStats();
+		mMeshStatsPrinted = true;
 	}
+}
 
-	std::cout << "Loaded " << chunksLoaded << " chunks.\n";
+void World::printMeshStats() const noexcept
+{
+	size_t numChunks = 0, numUniform = 0, numMeshes = 0, numVertices = 0, numTriangles = 0;
+	size_t vertexDataSize = 0, numVerticesUnculled = 0, numTrianglesUnculled = 0, voxelDataSize = 0;
+	for (size_t i = 0; i < mNumChunks; i++) {
+		if (!mAvailabilities[i]) continue;
+		numChunks++;
+		if (mChunks[i].uniform()) numUniform++;
+		voxelDataSize += mChunks[i].dataSize();
+		if (!mChunkMeshes[i]) continue;
+		const ChunkMesh& mesh = *mChunkMeshes[i];
+		numMeshes++;
+		numVertices += mesh.numVertices();
+		numTriangles += mesh.numTriangles();
+		vertexDataSize += mesh.vertexDataSize();
+		numVerticesUnculled += mesh.numVerticesUnculled();
+		numTrianglesUnculled += mesh.numTrianglesUnculled();
+	}
+	std::cout << "Meshed " << numChunks << " chunks (" << numUniform << " uniform, " << numMeshes
+	          << " with visible faces): " << numVertices << " vertices, "
+	          << numTriangles << " triangles (" << numVerticesUnculled << " vertices, "
+	          << numTrianglesUnculled << " triangles without hidden face culling), "
+	          << (vertexDataSize / 1024) << " KiB vertex data, " << (voxelDataSize / 1024)
+	          << " KiB voxel data.\n";
 }
 
 } // namespace vox
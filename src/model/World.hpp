@@ -6,13 +6,21 @@
 #include <cstdint> // uint8_t
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <sfz/Assert.hpp>
 #include <sfz/Math.hpp>
+#include <sfz/util/StopWatch.hpp>
 
 #include "model/Voxel.hpp"
 #include "model/Chunk.hpp"
+#include "model/ChunkLoader.hpp"
 #include "model/ChunkMesh.hpp"
+#include "model/ChunkMesher.hpp"
+#include "model/ChunkRing.hpp"
+#include "model/ChunkWriter.hpp"
+#include "model/PackedChunk.hpp"
+#include "model/TerrainGenerator.hpp"
 #include "io/ChunkIO.hpp"
 
 
@@ -20,7 +28,9 @@
 namespace vox {
 
 using std::size_t;
+using std::shared_ptr;
 using std::unique_ptr;
+using std::vector;
 using sfz::vec3;
 using sfz::vec3i;
 
@@ -37,32 +47,59 @@ public:
 	// Constructors & destructors
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-	World(const std::string& name, const vec3& camPos,
-	      size_t horizontalRange, size_t verticalRange) noexcept;
+	World(const std::string& name, const vec3& camPos, size_t horizontalRange,
+	      size_t verticalRange, const TerrainSettings& terrain = TerrainSettings{}) noexcept;
 
 	// Public member functions
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-	void update(const vec3& camPos) noexcept;
+	/**
+	 * @brief Updates which chunks are loaded, publishes chunks finished by the loader and uploads
+	 * meshes finished by the mesher. Meshes of new and modified chunks are built on the mesher's
+	 * worker threads. At most maxChunkUploads chunks are published, meshed and uploaded each, and
+	 * no new work is started after maxStreamingMs milliseconds, the rest is left for later frames.
+	 * 0 means unlimited.
+	 */
+	void update(const vec3& camPos, size_t maxChunkUploads = 0, float maxStreamingMs = 0.0f) noexcept;
 
 	vec3 positionFromChunkOffset(const vec3i& offset) const noexcept;
 
 	vec3i chunkOffsetFromPosition(const vec3i& position) const noexcept;
 	vec3i chunkOffsetFromPosition(const vec3& position) const noexcept;
 
+	/** @brief Sets the voxel, the modified chunk is written by the I/O thread (see ChunkWriter). */
 	void setVoxel(const vec3i& position, Voxel voxel) noexcept;
 	void setVoxel(const vec3& position, Voxel voxel) noexcept;
 
+	/**
+	 * @brief Blocks until all modified chunks are written and synced to the region files, returns
+	 * false if any write failed. Also done on destruction, but without reporting failures.
+	 */
+	bool flushChunks() noexcept;
+
 	// Getters / setters
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 	
 	inline vec3i currentChunkOffset() const noexcept { return mCurrentChunkOffset; }
+	inline size_t numChunksLoading() const noexcept { return mLoader.numPending(); }
+	inline size_t numChunksSaving() const noexcept { return mWriter.numPending(); }
+	inline size_t numChunksGenerated() const noexcept { return mNumChunksGenerated; }
+	inline size_t numMeshesPending() const noexcept { return mDirtyMeshes.size() + mMesher.numPending(); }
+	inline size_t lastNumChunkUploads() const noexcept { return mLastNumChunkUploads; }
+	inline float lastStreamingMs() const noexcept { return mLastStreamingMs; }
+	inline MeshingMode meshingMode() const noexcept { return mMeshingMode; }
+
+	/** @brief Sets the meshing mode and rebuilds the meshes of all loaded chunks. */
+	void meshingMode(MeshingMode mode) noexcept;
 
-	size_t chunkIndex(const Chunk* chunkPtr) const noexcept;
 	int chunkIndex(const vec3i& offset) const noexcept;
 
-	const Chunk* chunkPtr(size_t index) const noexcept;
-	const ChunkMesh& chunkMesh(size_t index) const noexcept;
+	/** @brief Returns the (palette compressed) chunk in the specified slot. */
+	const PackedChunk& packedChunk(size_t index) const noexcept;
+
+	/** @brief Returns the mesh in the specified slot, nullptr if the chunk has no visible faces. */
+	const ChunkMesh* chunkMesh(size_t index) const noexcept;
+
 	const vec3i chunkOffset(size_t index) const noexcept;
 	bool chunkAvailable(size_t index) const noexcept;
 
@@ -73,18 +110,51 @@ private:
 	// Private methods
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-	void checkWhichChunksToReplace() noexcept;
-	void loadChunks() noexcept;
+	void requestChunks(const vec3i& oldMin, const vec3i& oldMax) noexcept;
+	void publishLoadedChunks(size_t maxChunks, float maxStreamingMs,
+	                         sfz::StopWatch& stopWatch) noexcept;
+	void setChunk(size_t index, const Chunk& chunk) noexcept;
+	void updateBorders(size_t index, const Chunk& chunk) noexcept;
+	bool needsMesh(size_t index) const noexcept;
+	void releaseMesh(size_t index) noexcept;
+	void markMeshDirty(size_t index, uint8_t segmentMask = CHUNK_MESH_ALL_SEGMENTS) noexcept;
+	void requestDirtyMeshes(size_t maxJobs, float maxStreamingMs, sfz::StopWatch& stopWatch) noexcept;
+	const shared_ptr<const Chunk>& snapshot(size_t index) noexcept;
+	void uploadMeshedChunks(size_t maxChunkUploads, float maxStreamingMs,
+	                        sfz::StopWatch& stopWatch) noexcept;
+	void printMeshStats() const noexcept;
 
 	// Private Members
 	// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
 	vec3i mCurrentChunkOffset;
-	unique_ptr<Chunk[]> mChunks;
-	unique_ptr<ChunkMesh[]> mChunkMeshes;
+	const ChunkRing mRing;
+	unique_ptr<PackedChunk[]> mChunks; // Uniform chunks have no voxel storage
+	unique_ptr<uint8_t[]> mNonAirBorders; // Per chunk, one bit per direction, see borderOccupancy()
+	unique_ptr<uint8_t[]> mSolidBorders;
+	Chunk mEditChunk; // Unpacked copy of the chunk being edited, queued to the writer
+	unique_ptr<unique_ptr<ChunkMesh>[]> mChunkMeshes; // nullptr for chunks without visible faces
+	vector<unique_ptr<ChunkMesh>> mFreeMeshes; // Released meshes, kept to reuse their GL objects
 	unique_ptr<vec3i[]> mOffsets;
 	unique_ptr<bool[]> mAvailabilities;
-	unique_ptr<bool[]> mToBeReplaced;
+	const TerrainSettings mTerrain;
+	ChunkStorage mStorage;
+	ChunkWriter mWriter;
+	ChunkLoader mLoader;
+	vector<LoadedChunk> mLoadedChunks;
+	size_t mNumChunksGenerated = 0; // Published chunks that were generated rather than read
+	ChunkMesher mMesher;
+	uint32_t mLatestMeshVersion = 0;
+	unique_ptr<uint32_t[]> mSegmentVersions; // Latest job version requested for each mesh segment
+	unique_ptr<uint8_t[]> mDirtySegments;
+	vector<size_t> mDirtyMeshes;
+	unique_ptr<shared_ptr<const Chunk>[]> mSnapshots; // Unpacked once per frame for all mesh jobs
+	vector<size_t> mSnapshotIndices;
+	vector<MeshedChunk> mMeshedChunks;
+	size_t mLastNumChunkUploads = 0;
+	float mLastStreamingMs = 0.0f;
+	bool mMeshStatsPrinted = false; // Printed once, when the initial load has finished
+	MeshingMode mMeshingMode = MeshingMode::CULLED;
 };
 
 } // namespace vox
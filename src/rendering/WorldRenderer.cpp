@@ -9,6 +9,9 @@ namespace vox {
 
 namespace {
 
+// Size of the uVoxelUVRegions uniform array in gbuffer_gen.vert
+const size_t MAX_NUM_VOXEL_TYPES = 16;
+
 } // anonymous namespace
 
 // Constructors & destructors
@@ -28,10 +31,26 @@ void WorldRenderer::drawWorld(const ViewFrustum& cam, int modelMatrixLoc) noexce
 {
 	mat4 transform = sfz::identityMatrix4<float>();
 	AABB aabb;
-	glBindTexture(GL_TEXTURE_2D, Assets::INSTANCE().cubeFaceDiffuseTexture());
+	const Assets& assets = Assets::INSTANCE();
+	glBindTexture(GL_TEXTURE_2D, assets.cubeFaceDiffuseTexture());
+
+	// Chunk meshes use packed vertices, the texture atlas regions are looked up by voxel type
+	int program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	vec4 uvRegions[MAX_NUM_VOXEL_TYPES];
+	sfz_assert_debug(assets.numVoxelTypes() <= MAX_NUM_VOXEL_TYPES);
+	for (size_t i = 0; i < assets.numVoxelTypes(); i++) {
+		const TextureRegion& region = assets.cubeFaceRegion(Voxel{uint8_t(i)});
+		uvRegions[i] = vec4{region.mUVMin[0], region.mUVMin[1],
+		                    region.dimensions()[0], region.dimensions()[1]};
+	}
+	gl::setUniform(glGetUniformLocation(program, "uVoxelUVRegions"), uvRegions, assets.numVoxelTypes());
+	gl::setUniform(glGetUniformLocation(program, "uPackedVertices"), 1);
 
 	for (size_t i = 0; i < mWorld.mNumChunks; ++i) {
 		if (!mWorld.chunkAvailable(i)) continue;
+		const ChunkMesh* mesh = mWorld.chunkMesh(i);
+		if (mesh == nullptr) continue;
 
 		vec3i offset = mWorld.chunkOffset(i);
 		vec3 offsetVec = mWorld.positionFromChunkOffset(offset);
@@ -41,8 +60,10 @@ void WorldRenderer::drawWorld(const ViewFrustum& cam, int modelMatrixLoc) noexce
 
 		sfz::translation(transform, offsetVec);
 		gl::setUniform(modelMatrixLoc, transform);
-		mWorld.chunkMesh(i).render();
+		mesh->render();
 	}
+
+	gl::setUniform(glGetUniformLocation(program, "uPackedVertices"), 0);
 }
 
 void WorldRenderer::drawWorldOld(const ViewFrustum& cam, int modelMatrixLoc) noexcept
@@ -53,7 +74,8 @@ void WorldRenderer::drawWorldOld(const ViewFrustum& cam, int modelMatrixLoc) noe
 
 	for (size_t i = 0; i < mWorld.mNumChunks; i++) {
 		if (!mWorld.chunkAvailable(i)) continue;
-		const Chunk* chunkPtr = mWorld.chunkPtr(i);
+		const PackedChunk& packedChunk = mWorld.packedChunk(i);
+		if (packedChunk.uniform() && packedChunk.getVoxel(ChunkIterateBegin).mType == VOXEL_AIR) continue;
 
 		vec3i offset = mWorld.chunkOffset(i);
 		vec3 offsetVec = mWorld.positionFromChunkOffset(offset);
@@ -61,14 +83,23 @@ void WorldRenderer::drawWorldOld(const ViewFrustum& cam, int modelMatrixLoc) noe
 		calculateChunkAABB(aabb, offsetVec);
 		if (!cam.isVisible(aabb)) continue;
 
+		// Read straight from the palette compressed chunk, unpacking every chunk each frame is slow
 		ChunkIndex index = ChunkIterateBegin;
 		for (unsigned int part8i = 0; part8i < 8; part8i++) {
+			if (packedChunk.partAir(index, 512)) {
+				index.plusPart8();
+				continue;
+			}
 			calculateChunkPart8AABB(aabb, offsetVec, index);
 			if (!cam.isVisible(aabb)) {
 				index.plusPart8();
 				continue;
 			}
 			for (unsigned int part4i = 0; part4i < 8; part4i++) {
+				if (packedChunk.partAir(index, 64)) {
+					index.plusPart4();
+					continue;
+				}
 				calculateChunkPart4AABB(aabb, offsetVec, index);
 				if (!cam.isVisible(aabb)) {
 					index.plusPart4();
@@ -76,7 +107,7 @@ void WorldRenderer::drawWorldOld(const ViewFrustum& cam, int modelMatrixLoc) noe
 				}
 				for (unsigned int voxeli = 0; voxeli < 64; voxeli++) {
 
-					Voxel v = chunkPtr->getVoxel(index);
+					Voxel v = packedChunk.getVoxel(index);
 					if (v.mType == VOXEL_AIR) {
 						index++;
 						continue;
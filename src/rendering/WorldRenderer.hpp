@@ -15,6 +15,7 @@ namespace vox {
 
 using gl::ViewFrustum;
 using sfz::vec3;
+using sfz::vec4;
 using sfz::mat4;
 
 class WorldRenderer {
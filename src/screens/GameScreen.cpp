@@ -1,5 +1,7 @@
 #include "screens/GameScreen.hpp"
 
+#include <iostream>
+
 #include <sfz/util/IO.hpp>
 
 namespace vox {
@@ -85,6 +87,15 @@ static void drawPlacementCube(int modelMatrixLoc, const vec3& pos, Voxel voxel)
 	cubeObj.render();
 }
 
+static TerrainSettings terrainSettings(const ConfigData& cfg) noexcept
+{
+	TerrainSettings settings;
+	settings.type = static_cast<TerrainType>(cfg.terrainType);
+	settings.seed = static_cast<uint32_t>(cfg.terrainSeed);
+	settings.caves = cfg.terrainCaves;
+	return settings;
+}
+
 // Constructors & destructors
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
@@ -92,7 +103,8 @@ GameScreen::GameScreen(sdl::Window& window, const std::string& worldName)
 :
 	mCfg{GlobalConfig::INSTANCE()},
 	mWindow{window},
-	mWorld{worldName, vec3{-3.0f, 1.2f, 0.2f}, mCfg.horizontalRange, mCfg.verticalRange},
+	mWorld{worldName, vec3{-3.0f, 1.2f, 0.2f}, mCfg.horizontalRange, mCfg.verticalRange,
+	       terrainSettings(mCfg)},
 		
 	mSSAO{vec2i{window.drawableWidth(), window.drawableHeight()}, 32, 1.3f},
 
@@ -222,9 +234,18 @@ UpdateOp GameScreen::update(UpdateState& state)
 				break;
 			case 'p':
 			case 'P':
-				mOldWorldRenderer = !mOldWorldRenderer;
-				if (mOldWorldRenderer) std::cout << "Using old (non-meshed) world renderer.\n";
-				else std::cout << "Using (meshed) world renderer.\n";
+				// Cycles culled meshes -> greedy meshes -> old renderer
+				if (mOldWorldRenderer) {
+					mOldWorldRenderer = false;
+					mWorld.meshingMode(MeshingMode::CULLED);
+					std::cout << "Using (meshed) world renderer.\n";
+				} else if (mWorld.meshingMode() == MeshingMode::CULLED) {
+					mWorld.meshingMode(MeshingMode::GREEDY);
+					std::cout << "Using (greedy meshed) world renderer.\n";
+				} else {
+					mOldWorldRenderer = true;
+					std::cout << "Using old (non-meshed) world renderer.\n";
+				}
 				break;
 			case SDLK_UP:
 				{sfz::vec3 right = sfz::normalize(sfz::cross(mCam.dir(), mCam.up()));
@@ -337,7 +358,7 @@ UpdateOp GameScreen::update(UpdateState& state)
 		mCam.setDir(mCam.dir(), vec3{0.0f, 1.0f, 0.0f});
 	}
 
-	mWorld.update(mCam.pos());
+	mWorld.update(mCam.pos(), (size_t)mCfg.maxChunkUploadsPerFrame, mCfg.chunkStreamingBudgetMs);
 
 	updateResolutions(mWindow.drawableDimensions());
 	if (mCfg.continuousShaderReload) updatePrograms();
@@ -654,6 +675,11 @@ void GameScreen::render(UpdateState& state)
 		std::snprintf(longerTermPerfBuffer, 128, "Last %i frames: %s", mLongerTermPerfStats.currentNumSamples(), mLongerTermPerfStats.to_string());
 		char longestTermPerfBuffer[128];
 		std::snprintf(longestTermPerfBuffer, 128, "Last %i frames: %s", mLongestTermPerfStats.currentNumSamples(), mLongestTermPerfStats.to_string());
+		char streamingBuffer[160];
+		std::snprintf(streamingBuffer, 160, "Chunk streaming: %i uploads, %.2fms (budget %i, %.2fms), backlog %i loads %i meshes %i saves, %i generated",
+		              (int)mWorld.lastNumChunkUploads(), mWorld.lastStreamingMs(), mCfg.maxChunkUploadsPerFrame,
+		              mCfg.chunkStreamingBudgetMs, (int)mWorld.numChunksLoading(), (int)mWorld.numMeshesPending(),
+		              (int)mWorld.numChunksSaving(), (int)mWorld.numChunksGenerated());
 
 		float fontSize = state.window.drawableHeight()/32.0f;
 		float offset = fontSize*0.04f;
@@ -663,12 +689,14 @@ void GameScreen::render(UpdateState& state)
 		font.horizontalAlign(gl::HorizontalAlign::LEFT);
 
 		font.begin(state.window.drawableDimensions()/2.0f, state.window.drawableDimensions());
+		font.write(vec2{offset, bottomOffset + fontSize*3.15f - offset}, fontSize, streamingBuffer);
 		font.write(vec2{offset, bottomOffset + fontSize*2.10f - offset}, fontSize, shortTermPerfBuffer);
 		font.write(vec2{offset, bottomOffset + fontSize*1.05f - offset}, fontSize, longerTermPerfBuffer);
 		font.write(vec2{offset, bottomOffset - offset}, fontSize, longestTermPerfBuffer);
 		font.end(0, state.window.drawableDimensions(), sfz::vec4{0.0f, 0.0f, 0.0f, 1.0f});
 
 		font.begin(state.window.drawableDimensions()/2.0f, state.window.drawableDimensions());
+		font.write(vec2{0.0f, bottomOffset + fontSize*3.15f}, fontSize, streamingBuffer);
 		font.write(vec2{0.0f, bottomOffset + fontSize*2.10f}, fontSize, shortTermPerfBuffer);
 		font.write(vec2{0.0f, bottomOffset + fontSize*1.05f}, fontSize, longerTermPerfBuffer);
 		font.write(vec2{0.0f, bottomOffset}, fontSize, longestTermPerfBuffer);
@@ -695,7 +723,11 @@ void GameScreen::render(UpdateState& state)
 
 void GameScreen::onQuit()
 {
-
+	// Saved before the screen is torn down, so a failed save can still be reported
+	if (!mWorld.flushChunks()) {
+		std::cerr << "Couldn't save all modified chunks, they are retried when the world closes."
+		          << std::endl;
+	}
 }
 
 void GameScreen::onResize(vec2 dimensions, vec2 drawableDimensions)
@@ -714,6 +746,7 @@ void GameScreen::updatePrograms() noexcept
 		glBindAttribLocation(shaderProgram, 0, "inPosition");
 		glBindAttribLocation(shaderProgram, 1, "inNormal");
 		glBindAttribLocation(shaderProgram, 2, "inUVCoord");
+		glBindAttribLocation(shaderProgram, 3, "inPackedVertex");
 		glBindFragDataLocation(shaderProgram, 0, "outFragLinearDepth");
 		glBindFragDataLocation(shaderProgram, 1, "outFragNormal");
 		glBindFragDataLocation(shaderProgram, 2, "outFragDiffuse");
@@ -724,6 +757,7 @@ void GameScreen::updatePrograms() noexcept
 	                                      (sfz::basePath() + "assets/shaders/shadow_map.frag").c_str(),
 		[](uint32_t shaderProgram) {
 		glBindAttribLocation(shaderProgram, 0, "inPosition");
+		glBindAttribLocation(shaderProgram, 3, "inPackedVertex");
 		glBindFragDataLocation(shaderProgram, 0, "outFragColor");
 	});
 